@@ -76,4 +76,128 @@ __kernel void task1(
 	write_imagef(dst_image_horz, coord, pixelHorz);		// Write to dst_image for horizontal flip
 	write_imagef(dst_image_vert, coord, pixelVert);		// Write to dst_image for vertical flip
 	write_imagef(dst_image_both, coord, pixelBoth);		// Write to dst_image for both flips
+}
+
+// width and height of the tiles staged in local memory
+#define TILE_SIZE 16
+
+// orientation bits, flips are applied before the transpose
+#define FLIP_X 1
+#define FLIP_Y 2
+#define TRANSPOSE 4
+
+// maps a position inside a size x size square to where the orientation moves it
+int2 dihedral_map(int2 pos, int2 size, int orientation) {
+	if (orientation & FLIP_X) {
+		pos.x = size.x - 1 - pos.x;
+	}
+	if (orientation & FLIP_Y) {
+		pos.y = size.y - 1 - pos.y;
+	}
+	if (orientation & TRANSPOSE) {
+		pos = pos.yx;
+	}
+	return pos;
+}
+
+// maps a destination position back to the source position it is copied from
+int2 dihedral_unmap(int2 pos, int2 size, int orientation) {
+	if (orientation & TRANSPOSE) {
+		pos = pos.yx;
+	}
+	if (orientation & FLIP_X) {
+		pos.x = size.x - 1 - pos.x;
+	}
+	if (orientation & FLIP_Y) {
+		pos.y = size.y - 1 - pos.y;
+	}
+	return pos;
+}
+
+__kernel void dihedral_transform(
+	__global const uchar4* src_buffer,
+	__global uchar4* dst_buffer,
+	int width,
+	int height,
+	int orientation
+) {
+	// padded by one column so reading a tile column does not hit the same bank
+	__local uchar4 tile[TILE_SIZE][TILE_SIZE + 1];
+
+	int2 lid = (int2)(get_local_id(0), get_local_id(1));
+
+	// source tile bounds, clipped to the image
+	int2 start = (int2)(get_group_id(0), get_group_id(1)) * TILE_SIZE;
+	int2 end = min(start + TILE_SIZE, (int2)(width, height));
+
+	// read the tile row by row, neighbouring work-items read neighbouring pixels
+	int2 coord = start + lid;
+	if (coord.x < width && coord.y < height) {
+		tile[lid.y][lid.x] = src_buffer[coord.y * width + coord.x];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// corner of the flipped tile, then of the destination tile
+	int2 flipped = start;
+	if (orientation & FLIP_X) {
+		flipped.x = width - end.x;
+	}
+	if (orientation & FLIP_Y) {
+		flipped.y = height - end.y;
+	}
+	int2 dst_start = (orientation & TRANSPOSE) ? flipped.yx : flipped;
+	int dst_width = (orientation & TRANSPOSE) ? height : width;
+
+	// write the destination tile row by row, fetching the matching pixel from the tile
+	int2 dst = dst_start + lid;
+	int2 src = dihedral_unmap(dst, (int2)(width, height), orientation);
+
+	if (src.x >= start.x && src.x < end.x && src.y >= start.y && src.y < end.y) {
+		dst_buffer[dst.y * dst_width + dst.x] = tile[src.y - start.y][src.x - start.x];
+	}
+}
+
+__kernel void dihedral_transform_in_place(
+	__global uchar4* image_buffer,
+	int size,
+	int orientation
+) {
+	// a tile's orbit under the orientation has at most 4 tiles (90 degree rotations)
+	__local uchar4 tiles[4][TILE_SIZE][TILE_SIZE + 1];
+
+	int2 lid = (int2)(get_local_id(0), get_local_id(1));
+	int num_tiles = size / TILE_SIZE;
+
+	// collect the orbit of this work-group's tile
+	int2 orbit[4];
+	int length = 0;
+	int2 first = (int2)(get_group_id(0), get_group_id(1));
+	int2 t = first;
+
+	do {
+		orbit[length++] = t;
+		t = dihedral_map(t, (int2)(num_tiles, num_tiles), orientation);
+	} while ((t.x != first.x || t.y != first.y) && length < 4);
+
+	// the orbit is handled by the work-group of its lowest numbered tile
+	for (int k = 1; k < length; k++) {
+		if (orbit[k].y * num_tiles + orbit[k].x < first.y * num_tiles + first.x) {
+			return;
+		}
+	}
+
+	// read every tile of the orbit before any is overwritten
+	for (int k = 0; k < length; k++) {
+		int2 coord = orbit[k] * TILE_SIZE + lid;
+		tiles[k][lid.y][lid.x] = image_buffer[coord.y * size + coord.x];
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// each tile's contents move to the next tile of the orbit
+	int2 src = dihedral_unmap(lid, (int2)(TILE_SIZE, TILE_SIZE), orientation);
+
+	for (int k = 0; k < length; k++) {
+		int2 coord = orbit[(k + 1) % length] * TILE_SIZE + lid;
+		image_buffer[coord.y * size + coord.x] = tiles[k][src.y][src.x];
+	}
 }
\ No newline at end of file
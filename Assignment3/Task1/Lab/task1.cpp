@@ -17,6 +17,21 @@
 #include "common.h"
 #include "bmpfuncs.h"
 
+#define TILE_SIZE 16			// must match TILE_SIZE in task1.cl
+#define NUM_ORIENTATIONS 8
+
+// orientation bits, same as in task1.cl
+#define FLIP_X 1
+#define FLIP_Y 2
+#define TRANSPOSE 4
+
+// output file for each orientation, indexed by its bits
+// BMP rows are stored bottom-up, so transposing the buffer mirrors the displayed image about its anti-diagonal
+const char* orientationFiles[NUM_ORIENTATIONS] = {
+	"Task1_identity.bmp", "Task1_flip_x.bmp", "Task1_flip_y.bmp", "Task1_rotate180.bmp",
+	"Task1_antitranspose.bmp", "Task1_rotate90cw.bmp", "Task1_rotate90ccw.bmp", "Task1_transpose.bmp"
+};
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
@@ -35,6 +50,8 @@ int main(void)
 
 	cl::ImageFormat imgFormat;
 	cl::Image2D inputImgBuffer, outputImgBufferHorz, outputImgBufferVert, outputImgBufferBoth;
+	cl::Buffer inputPixelBuffer, outputPixelBuffer;
+	unsigned char* outputImageOriented;
 
 	try {
 		// select an OpenCL device
@@ -109,6 +126,61 @@ int main(void)
 		write_BMP_RGBA_to_RGB("Task1b.bmp", outputImageVert, imgWidth, imgHeight);
 		write_BMP_RGBA_to_RGB("Task1c.bmp", outputImageBoth, imgWidth, imgHeight);
 
+		// tiled dihedral transforms on packed RGBA buffers
+		kernel = cl::Kernel(program, "dihedral_transform");
+
+		outputImageOriented = new unsigned char[imageSize];
+		inputPixelBuffer = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(cl_uchar) * imageSize, (void*)inputImage);
+		outputPixelBuffer = cl::Buffer(context, CL_MEM_WRITE_ONLY, sizeof(cl_uchar) * imageSize);
+
+		// one work-group per tile, global size rounded up to whole tiles
+		cl::NDRange tileSize(TILE_SIZE, TILE_SIZE);
+		cl::NDRange tiledGlobalSize((imgWidth + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE, (imgHeight + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE);
+
+		kernel.setArg(0, inputPixelBuffer);
+		kernel.setArg(1, outputPixelBuffer);
+		kernel.setArg(2, imgWidth);
+		kernel.setArg(3, imgHeight);
+
+		for (int i = 0; i < NUM_ORIENTATIONS; i++)
+		{
+			kernel.setArg(4, i);
+			queue.enqueueNDRangeKernel(kernel, offset, tiledGlobalSize, tileSize);
+
+			// enqueue command to read buffer from device to host memory
+			queue.enqueueReadBuffer(outputPixelBuffer, CL_TRUE, 0, sizeof(cl_uchar) * imageSize, outputImageOriented);
+
+			// transposed orientations swap the image dimensions
+			if (i & TRANSPOSE)
+				write_BMP_RGBA_to_RGB(orientationFiles[i], outputImageOriented, imgHeight, imgWidth);
+			else
+				write_BMP_RGBA_to_RGB(orientationFiles[i], outputImageOriented, imgWidth, imgHeight);
+		}
+
+		std::cout << "Dihedral transform Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// square images made of whole tiles can be rotated without a second buffer
+		if (imgWidth == imgHeight && imgWidth % TILE_SIZE == 0)
+		{
+			kernel = cl::Kernel(program, "dihedral_transform_in_place");
+
+			kernel.setArg(0, inputPixelBuffer);
+			kernel.setArg(1, imgWidth);
+			kernel.setArg(2, TRANSPOSE | FLIP_X);
+
+			queue.enqueueNDRangeKernel(kernel, offset, tiledGlobalSize, tileSize);
+
+			std::cout << "In-place rotation Kernel enqueued." << std::endl;
+			std::cout << "--------------------" << std::endl;
+
+			// enqueue command to read buffer from device to host memory
+			queue.enqueueReadBuffer(inputPixelBuffer, CL_TRUE, 0, sizeof(cl_uchar) * imageSize, outputImageOriented);
+
+			// output results to image file
+			write_BMP_RGBA_to_RGB("Task1_in_place.bmp", outputImageOriented, imgWidth, imgHeight);
+		}
+
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
@@ -116,6 +188,7 @@ int main(void)
 		free(outputImageHorz);
 		free(outputImageVert);
 		free(outputImageBoth);
+		delete[] outputImageOriented;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {
@@ -1,6 +1,13 @@
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | 
       CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
 
+__constant float Weights[7] = {
+	0.00598, 0.060626, 0.241843, 0.383103, 0.241843, 0.060626, 0.00598
+};
+
+// transposes 4 RGBA pixels into RRRR GGGG BBBB AAAA, and back again
+__constant uchar16 TransposeMask = (uchar16)(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
 __kernel void task2(
 	read_only image2d_t src_image,
 	write_only image2d_t dst_image
@@ -19,4 +26,222 @@ __kernel void task2(
 
 	// write new pixel value to output
 	write_imagef(dst_image, coord, pixel);
-}
\ No newline at end of file
+}
+
+__kernel void task2_packed(
+	__global const uchar* src_buffer,
+	__global uchar* dst_buffer,
+	int num_pixels
+) {
+	// each work-item converts 4 RGBA pixels
+	int id = get_global_id(0);
+	int first = id * 4;
+
+	if (first + 4 <= num_pixels) {
+		// read 4 packed pixels at once
+		uchar16 pixels = vload16(id, src_buffer);
+
+		// widen so the weighted sums do not overflow, weights 77, 150, 29 sum to 256
+		ushort4 r = convert_ushort4(pixels.s048c);
+		ushort4 g = convert_ushort4(pixels.s159d);
+		ushort4 b = convert_ushort4(pixels.s26ae);
+		uchar4 lum = convert_uchar4((r * (ushort)77 + g * (ushort)150 + b * (ushort)29 + (ushort)128) >> (ushort)8);
+
+		// replace RGB values with luminance and keep alpha
+		uchar4 a = pixels.s37bf;
+		vstore16((uchar16)(lum.xxx, a.x, lum.yyy, a.y, lum.zzz, a.z, lum.www, a.w), id, dst_buffer);
+	}
+	else {
+		// remaining pixels when the image size is not a multiple of 4
+		for (int i = first; i < num_pixels; i++) {
+			uchar4 pixel = vload4(i, src_buffer);
+			uchar lum = (uchar)((pixel.x * 77 + pixel.y * 150 + pixel.z * 29 + 128) >> 8);
+			vstore4((uchar4)(lum, lum, lum, pixel.w), i, dst_buffer);
+		}
+	}
+}
+
+__kernel void rgba_to_planar(
+	__global const uchar* src_buffer,
+	__global float* planes,
+	int num_pixels
+) {
+	// each work-item converts 4 RGBA pixels into 4 pixels of each colour plane
+	int id = get_global_id(0);
+	int first = id * 4;
+
+	if (first + 4 <= num_pixels) {
+		// group the channels of the 4 pixels together
+		uchar16 channels = shuffle(vload16(id, src_buffer), TransposeMask);
+
+		vstore4(convert_float4(channels.s0123) / 255.0f, id, planes);
+		vstore4(convert_float4(channels.s4567) / 255.0f, id, planes + num_pixels);
+		vstore4(convert_float4(channels.s89ab) / 255.0f, id, planes + 2 * num_pixels);
+	}
+	else {
+		// remaining pixels when the image size is not a multiple of 4
+		for (int i = first; i < num_pixels; i++) {
+			uchar4 pixel = vload4(i, src_buffer);
+			planes[i] = pixel.x / 255.0f;
+			planes[i + num_pixels] = pixel.y / 255.0f;
+			planes[i + 2 * num_pixels] = pixel.z / 255.0f;
+		}
+	}
+}
+
+__kernel void planar_to_rgba(
+	__global const float* planes,
+	int plane_stride,
+	__global uchar* dst_buffer,
+	int num_pixels
+) {
+	// a plane stride of 0 repeats one plane into RGB for grey images
+	int id = get_global_id(0);
+	int first = id * 4;
+
+	if (first + 4 <= num_pixels) {
+		uchar4 r = convert_uchar4_sat_rte(vload4(id, planes) * 255.0f);
+		uchar4 g = convert_uchar4_sat_rte(vload4(id, planes + plane_stride) * 255.0f);
+		uchar4 b = convert_uchar4_sat_rte(vload4(id, planes + 2 * plane_stride) * 255.0f);
+		uchar4 a = (uchar4)(255);
+
+		// interleave the planes back into 4 RGBA pixels
+		vstore16(shuffle2((uchar8)(r, g), (uchar8)(b, a), TransposeMask), id, dst_buffer);
+	}
+	else {
+		// remaining pixels when the image size is not a multiple of 4
+		for (int i = first; i < num_pixels; i++) {
+			float4 pixel = (float4)(planes[i], planes[i + plane_stride], planes[i + 2 * plane_stride], 1.0f);
+			vstore4(convert_uchar4_sat_rte(pixel * 255.0f), i, dst_buffer);
+		}
+	}
+}
+
+__kernel void rgba_to_planar_u8(
+	__global const uchar* src_buffer,
+	__global uchar* planes,
+	int num_pixels
+) {
+	// each work-item converts 4 RGBA pixels, channels stay 8-bit
+	int id = get_global_id(0);
+	int first = id * 4;
+
+	if (first + 4 <= num_pixels) {
+		uchar16 channels = shuffle(vload16(id, src_buffer), TransposeMask);
+
+		vstore4(channels.s0123, id, planes);
+		vstore4(channels.s4567, id, planes + num_pixels);
+		vstore4(channels.s89ab, id, planes + 2 * num_pixels);
+	}
+	else {
+		for (int i = first; i < num_pixels; i++) {
+			uchar4 pixel = vload4(i, src_buffer);
+			planes[i] = pixel.x;
+			planes[i + num_pixels] = pixel.y;
+			planes[i + 2 * num_pixels] = pixel.z;
+		}
+	}
+}
+
+__kernel void planar_u8_to_rgba(
+	__global const uchar* planes,
+	__global uchar* dst_buffer,
+	int num_pixels
+) {
+	// each work-item interleaves 4 pixels of 8-bit planes
+	int id = get_global_id(0);
+	int first = id * 4;
+
+	if (first + 4 <= num_pixels) {
+		uchar8 rg = (uchar8)(vload4(id, planes), vload4(id, planes + num_pixels));
+		uchar8 ba = (uchar8)(vload4(id, planes + 2 * num_pixels), (uchar4)(255));
+
+		vstore16(shuffle2(rg, ba, TransposeMask), id, dst_buffer);
+	}
+	else {
+		for (int i = first; i < num_pixels; i++) {
+			vstore4((uchar4)(planes[i], planes[i + num_pixels], planes[i + 2 * num_pixels], 255), i, dst_buffer);
+		}
+	}
+}
+
+__kernel void planar_luminance(
+	__global const float* planes,
+	__global float* lum_plane,
+	int num_pixels
+) {
+	// each work-item computes the luminance of 16 pixels, no lanes are spent on alpha
+	int id = get_global_id(0);
+	int first = id * 16;
+
+	if (first + 16 <= num_pixels) {
+		float16 r = vload16(id, planes);
+		float16 g = vload16(id, planes + num_pixels);
+		float16 b = vload16(id, planes + 2 * num_pixels);
+
+		vstore16(0.299f * r + 0.587f * g + 0.114f * b, id, lum_plane);
+	}
+	else {
+		// remaining pixels when the image size is not a multiple of 16
+		for (int i = first; i < num_pixels; i++) {
+			lum_plane[i] = 0.299f * planes[i] + 0.587f * planes[i + num_pixels] + 0.114f * planes[i + 2 * num_pixels];
+		}
+	}
+}
+
+// reads one value of a plane, edge values repeat outside the image
+float planar_tap(__global const float* plane, int width, int height, int x, int y) {
+	x = clamp(x, 0, width - 1);
+	y = clamp(y, 0, height - 1);
+
+	return plane[y * width + x];
+}
+
+__kernel void planar_blur_pass(
+	__global const float* src_planes,
+	__global float* dst_planes,
+	int width,
+	int height,
+	int pass_type
+) {
+	// each work-item blurs 4 neighbouring pixels of a row in one plane
+	int x = get_global_id(0) * 4;
+	int y = get_global_id(1);
+	int plane_offset = get_global_id(2) * width * height;
+
+	__global const float* src = src_planes + plane_offset;
+	__global float* dst = dst_planes + plane_offset + y * width;
+
+	float4 sum = (float4)(0.0f);
+
+	// Horizontal pass, interior pixels read whole vectors
+	if (pass_type == 0 && x >= 3 && x + 7 <= width) {
+		for (int i = 0; i < 7; i++) {
+			sum += Weights[i] * vload4(0, src + y * width + x - 3 + i);
+		}
+	}
+	// Vertical pass, one row of 4 values per tap with the row clamped at the edges
+	else if (pass_type == 1 && x + 4 <= width) {
+		for (int i = 0; i < 7; i++) {
+			sum += Weights[i] * vload4(0, src + clamp(y - 3 + i, 0, height - 1) * width + x);
+		}
+	}
+	// pixels near the left and right edges
+	else {
+		for (int k = 0; k < 4 && x + k < width; k++) {
+			float value = 0.0f;
+
+			for (int i = 0; i < 7; i++) {
+				if (pass_type == 0)
+					value += Weights[i] * planar_tap(src, width, height, x + k - 3 + i, y);
+				else
+					value += Weights[i] * planar_tap(src, width, height, x + k, y - 3 + i);
+			}
+			dst[x + k] = value;
+		}
+		return;
+	}
+
+	// write new pixel values to output
+	vstore4(sum, 0, dst + x);
+}
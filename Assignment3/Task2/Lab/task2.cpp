@@ -17,22 +17,50 @@
 #include "common.h"
 #include "bmpfuncs.h"
 
+#define NUM_ITERATIONS 1000
+
+enum Kernels {IMAGE, PACKED};
+
+// enqueues a kernel NUM_ITERATIONS times and returns its average execution time
+cl_ulong average_kernel_time(cl::CommandQueue* queue, cl::Kernel* kernel, cl::NDRange offset, cl::NDRange globalSize)
+{
+	cl::Event profileEvent;
+	cl_ulong timeTotal = 0;
+
+	for (int i = 0; i < NUM_ITERATIONS; i++)
+	{
+		queue->enqueueNDRangeKernel(*kernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
+		queue->finish();
+
+		timeTotal += profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>() - profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+	}
+
+	return timeTotal / NUM_ITERATIONS;
+}
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
 	cl::Device device;				// device used
 	cl::Context context;			// context for the device
 	cl::Program program;			// OpenCL program object
-	cl::Kernel kernel;				// a single kernel object
+	cl::Kernel kernel[2];			// kernel objects
 	cl::CommandQueue queue;			// commandqueue for a context and device
 
 	// declare data and memory objects
 	unsigned char* inputImage;
 	unsigned char* outputImage;
-	int imgWidth, imgHeight, imageSize;
+	unsigned char* outputImagePacked;
+	unsigned char* outputImagePlanar;
+	int imgWidth, imgHeight, imageSize, numPixels, numMismatches;
 
 	cl::ImageFormat imgFormat;
 	cl::Image2D inputImgBuffer, outputImgBuffer;
+	cl::Buffer inputPackedBuffer, outputPackedBuffer;
+	cl::Buffer planeBuffer, lumPlaneBuffer, blurPlaneBuffer, planeU8Buffer;
+
+	// average execution time of each kernel
+	cl_ulong timeAverage[2];
 
 	try {
 		// select an OpenCL device
@@ -52,18 +80,22 @@ int main(void)
 			quit_program("OpenCL program build error.");
 		}
 
-		// create a kernel
-		kernel = cl::Kernel(program, "task2");
+		// create kernels
+		kernel[IMAGE] = cl::Kernel(program, "task2");
+		kernel[PACKED] = cl::Kernel(program, "task2_packed");
 
 		// create command queue
-		queue = cl::CommandQueue(context, device);
+		queue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
 		
 		// read input image
 		inputImage = read_BMP_RGB_to_RGBA("peppers.bmp", &imgWidth, &imgHeight);
 
 		// allocate memory for output image
-		imageSize = imgWidth * imgHeight * 4;
+		numPixels = imgWidth * imgHeight;
+		imageSize = numPixels * 4;
 		outputImage = new unsigned char[imageSize];
+		outputImagePacked = new unsigned char[imageSize];
+		outputImagePlanar = new unsigned char[imageSize];
 
 		// image format
 		imgFormat = cl::ImageFormat(CL_RGBA, CL_UNORM_INT8);
@@ -72,17 +104,28 @@ int main(void)
 		inputImgBuffer = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)inputImage);
 		outputImgBuffer = cl::Image2D(context, CL_MEM_WRITE_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)outputImage);
 
+		// create packed RGBA buffers for the buffer variant
+		inputPackedBuffer = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uchar) * imageSize, (void*)inputImage);
+		outputPackedBuffer = cl::Buffer(context, CL_MEM_WRITE_ONLY, sizeof(cl_uchar) * imageSize);
+
 		// set kernel arguments
-		kernel.setArg(0, inputImgBuffer);
-		kernel.setArg(1, outputImgBuffer);
+		kernel[IMAGE].setArg(0, inputImgBuffer);
+		kernel[IMAGE].setArg(1, outputImgBuffer);
 
-		// enqueue kernel
-		cl::NDRange offset(0, 0);
-		cl::NDRange globalSize(imgWidth, imgHeight);
+		kernel[PACKED].setArg(0, inputPackedBuffer);
+		kernel[PACKED].setArg(1, outputPackedBuffer);
+		kernel[PACKED].setArg(2, numPixels);
 
-		queue.enqueueNDRangeKernel(kernel, offset, globalSize);
+		// one work-item per pixel for images, per 4 pixels for packed buffers
+		cl::NDRange globalSize[2] = { cl::NDRange(imgWidth, imgHeight), cl::NDRange((numPixels + 3) / 4) };
+		cl::NDRange offset[2] = { cl::NDRange(0, 0), cl::NDRange(0) };
 
-		std::cout << "Kernel enqueued." << std::endl;
+		for (int k = 0; k < 2; k++)
+		{
+			timeAverage[k] = average_kernel_time(&queue, &kernel[k], offset[k], globalSize[k]);
+		}
+
+		std::cout << "Kernels enqueued." << std::endl;
 		std::cout << "--------------------" << std::endl;
 
 		// enqueue command to read image from device to host memory
@@ -94,14 +137,140 @@ int main(void)
 
 		queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
 
+		// enqueue command to read packed buffer from device to host memory
+		queue.enqueueReadBuffer(outputPackedBuffer, CL_TRUE, 0, sizeof(cl_uchar) * imageSize, outputImagePacked);
+
 		// output results to image file
 		write_BMP_RGBA_to_RGB("Task2.bmp", outputImage, imgWidth, imgHeight);
 
+		// integer weights may round differently from the float weights by one level
+		numMismatches = 0;
+		for (int i = 0; i < imageSize; i++)
+		{
+			if (abs(outputImage[i] - outputImagePacked[i]) > 1 && i % 4 != 3)
+			{
+				numMismatches++;
+			}
+		}
+
+		// output average execution times
+		std::cout << "Image kernel average execution time: " << timeAverage[IMAGE] << std::endl;
+		std::cout << "Packed kernel average execution time: " << timeAverage[PACKED] << std::endl;
+		std::cout << "Channels differing by more than 1: " << numMismatches << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// planar layout, one float plane per colour channel and no alpha
+		planeBuffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_float) * numPixels * 3);
+		blurPlaneBuffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_float) * numPixels * 3);
+		lumPlaneBuffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_float) * numPixels);
+		planeU8Buffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_uchar) * numPixels * 3);
+
+		cl::Kernel toPlanarKernel(program, "rgba_to_planar");
+		cl::Kernel toRgbaKernel(program, "planar_to_rgba");
+		cl::Kernel toPlanarU8Kernel(program, "rgba_to_planar_u8");
+		cl::Kernel toRgbaU8Kernel(program, "planar_u8_to_rgba");
+		cl::Kernel lumKernel(program, "planar_luminance");
+		cl::Kernel blurKernel(program, "planar_blur_pass");
+
+		// conversions handle 4 pixels per work-item, luminance 16
+		cl::NDRange quadSize((numPixels + 3) / 4);
+		cl::NDRange lumSize((numPixels + 15) / 16);
+
+		toPlanarKernel.setArg(0, inputPackedBuffer);
+		toPlanarKernel.setArg(1, planeBuffer);
+		toPlanarKernel.setArg(2, numPixels);
+
+		lumKernel.setArg(0, planeBuffer);
+		lumKernel.setArg(1, lumPlaneBuffer);
+		lumKernel.setArg(2, numPixels);
+
+		cl_ulong toPlanarTime = average_kernel_time(&queue, &toPlanarKernel, cl::NDRange(0), quadSize);
+		cl_ulong lumTime = average_kernel_time(&queue, &lumKernel, cl::NDRange(0), lumSize);
+
+		// grey image from the luminance plane, a plane stride of 0 repeats it into RGB
+		toRgbaKernel.setArg(0, lumPlaneBuffer);
+		toRgbaKernel.setArg(1, 0);
+		toRgbaKernel.setArg(2, outputPackedBuffer);
+		toRgbaKernel.setArg(3, numPixels);
+
+		cl_ulong toRgbaTime = average_kernel_time(&queue, &toRgbaKernel, cl::NDRange(0), quadSize);
+
+		queue.enqueueReadBuffer(outputPackedBuffer, CL_TRUE, 0, sizeof(cl_uchar) * imageSize, outputImagePlanar);
+
+		numMismatches = 0;
+		for (int i = 0; i < imageSize; i++)
+		{
+			if (abs(outputImage[i] - outputImagePlanar[i]) > 1)
+			{
+				numMismatches++;
+			}
+		}
+
+		std::cout << "RGBA to planar average execution time: " << toPlanarTime << std::endl;
+		std::cout << "Planar luminance average execution time: " << lumTime << std::endl;
+		std::cout << "Planar to RGBA average execution time: " << toRgbaTime << std::endl;
+		std::cout << "Planar channels differing by more than 1: " << numMismatches << std::endl;
+
+		// separable blur of the three planes, 4 pixels of one plane per work-item
+		cl::NDRange blurSize((imgWidth + 3) / 4, imgHeight, 3);
+
+		blurKernel.setArg(0, planeBuffer);
+		blurKernel.setArg(1, blurPlaneBuffer);
+		blurKernel.setArg(2, imgWidth);
+		blurKernel.setArg(3, imgHeight);
+		blurKernel.setArg(4, 0);
+
+		cl_ulong blurTime = average_kernel_time(&queue, &blurKernel, cl::NDRange(0, 0, 0), blurSize);
+
+		blurKernel.setArg(0, blurPlaneBuffer);
+		blurKernel.setArg(1, planeBuffer);
+		blurKernel.setArg(4, 1);
+
+		blurTime += average_kernel_time(&queue, &blurKernel, cl::NDRange(0, 0, 0), blurSize);
+
+		toRgbaKernel.setArg(0, planeBuffer);
+		toRgbaKernel.setArg(1, numPixels);
+
+		queue.enqueueNDRangeKernel(toRgbaKernel, cl::NDRange(0), quadSize);
+		queue.enqueueReadBuffer(outputPackedBuffer, CL_TRUE, 0, sizeof(cl_uchar) * imageSize, outputImagePlanar);
+
+		write_BMP_RGBA_to_RGB("Task2_blur.bmp", outputImagePlanar, imgWidth, imgHeight);
+
+		std::cout << "Planar blur (both passes) average execution time: " << blurTime << std::endl;
+
+		// 8-bit planes must survive the round trip unchanged
+		toPlanarU8Kernel.setArg(0, inputPackedBuffer);
+		toPlanarU8Kernel.setArg(1, planeU8Buffer);
+		toPlanarU8Kernel.setArg(2, numPixels);
+
+		toRgbaU8Kernel.setArg(0, planeU8Buffer);
+		toRgbaU8Kernel.setArg(1, outputPackedBuffer);
+		toRgbaU8Kernel.setArg(2, numPixels);
+
+		cl_ulong u8Time = average_kernel_time(&queue, &toPlanarU8Kernel, cl::NDRange(0), quadSize);
+		u8Time += average_kernel_time(&queue, &toRgbaU8Kernel, cl::NDRange(0), quadSize);
+
+		queue.enqueueReadBuffer(outputPackedBuffer, CL_TRUE, 0, sizeof(cl_uchar) * imageSize, outputImagePlanar);
+
+		numMismatches = 0;
+		for (int i = 0; i < imageSize; i++)
+		{
+			if (outputImagePlanar[i] != inputImage[i])
+			{
+				numMismatches++;
+			}
+		}
+
+		std::cout << "8-bit planar round trip average execution time: " << u8Time << std::endl;
+		std::cout << "8-bit round trip mismatches: " << numMismatches << std::endl;
+
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
 		free(inputImage);
-		free(outputImage);
+		delete[] outputImage;
+		delete[] outputImagePacked;
+		delete[] outputImagePlanar;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {
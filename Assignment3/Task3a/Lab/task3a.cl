@@ -12,6 +12,12 @@ __constant float GaussFilter[49] = {
 	0.000036, 0.000363, 0.001446, 0.002291, 0.001446, 0.000363, 0.000036
 };
 
+// 1D Gaussian weights scaled to 256 and rounded, the 7x7 filter is their outer product
+// and sums to 65536, so the result is normalised with a shift
+__constant uint IntWeights[7] = {
+	2, 16, 62, 96, 62, 16, 2
+};
+
 __kernel void gauss_conv(read_only image2d_t src_image,
 					write_only image2d_t dst_image) {
 
@@ -47,4 +53,110 @@ __kernel void gauss_conv(read_only image2d_t src_image,
    // write new pixel value to output
    coord = (int2)(column, row); 
    write_imagef(dst_image, coord, sum);
-}
\ No newline at end of file
+}
+
+__kernel void gauss_conv_int(read_only image2d_t src_image,
+					write_only image2d_t dst_image) {
+
+   // get work-item's row and column position
+   int column = get_global_id(0);
+   int row = get_global_id(1);
+
+   // accumulated pixel value, no conversion to float on any tap
+   uint4 sum = (uint4)(0);
+
+   int2 coord;
+
+   // iterate over the rows
+   for(int i = -3; i <= 3; i++) {
+	  coord.y = row + i;
+
+      // iterate over the columns
+	  for(int j = -3; j <= 3; j++) {
+         coord.x = column + j;
+
+		 // acculumate weighted sum
+		 sum += read_imageui(src_image, sampler, coord) * (IntWeights[i + 3] * IntWeights[j + 3]);
+	  }
+   }
+
+   // divide by 65536 with rounding
+   sum = (sum + 32768) >> 16;
+   sum.w = 255;
+
+   // write new pixel value to output
+   coord = (int2)(column, row);
+   write_imageui(dst_image, coord, sum);
+}
+
+#define BILATERAL_RADIUS 3
+#define BILATERAL_TILE 16
+#define BILATERAL_WIDTH (2 * BILATERAL_RADIUS + 1)
+#define RANGE_LEVELS 256		// entries of the range weight lookup table
+
+__kernel void bilateral_conv(read_only image2d_t src_image,
+					write_only image2d_t dst_image,
+					__constant float* spatial_weights,
+					__constant float* range_weights) {
+
+   // tile of the work-group plus a halo of the filter radius on every side
+   __local float4 tile[BILATERAL_TILE + 2 * BILATERAL_RADIUS][BILATERAL_TILE + 2 * BILATERAL_RADIUS];
+
+   // get work-item's row and column position
+   int column = get_global_id(0);
+   int row = get_global_id(1);
+   int local_column = get_local_id(0);
+   int local_row = get_local_id(1);
+
+   // top-left pixel of the halo
+   int2 origin = (int2)(get_group_id(0) * BILATERAL_TILE - BILATERAL_RADIUS,
+						get_group_id(1) * BILATERAL_TILE - BILATERAL_RADIUS);
+
+   // stage the tile, each work-item loads a strided subset
+   for(int y = local_row; y < BILATERAL_TILE + 2 * BILATERAL_RADIUS; y += BILATERAL_TILE) {
+	  for(int x = local_column; x < BILATERAL_TILE + 2 * BILATERAL_RADIUS; x += BILATERAL_TILE) {
+		 tile[y][x] = read_imagef(src_image, sampler, origin + (int2)(x, y));
+	  }
+   }
+
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   // work-items past the edge of the image only helped with the loading
+   int2 dim = get_image_dim(src_image);
+   if(column >= dim.x || row >= dim.y)
+	  return;
+
+   float4 centre = tile[local_row + BILATERAL_RADIUS][local_column + BILATERAL_RADIUS];
+
+   // accumulated pixel value and weight
+   float4 sum = (float4)(0.0);
+   float weight_sum = 0.0f;
+
+   // filter's current index
+   int filter_index = 0;
+
+   // iterate over the rows
+   for(int i = 0; i < BILATERAL_WIDTH; i++) {
+
+      // iterate over the columns
+	  for(int j = 0; j < BILATERAL_WIDTH; j++) {
+		 float4 pixel = tile[local_row + i][local_column + j];
+
+		 // range weight looked up from the quantised colour difference
+		 float3 diff = fabs(pixel.xyz - centre.xyz);
+		 int level = min(convert_int((diff.x + diff.y + diff.z) * (RANGE_LEVELS - 1) / 3.0f), RANGE_LEVELS - 1);
+		 float weight = spatial_weights[filter_index++] * range_weights[level];
+
+		 // acculumate weighted sum
+		 sum.xyz += pixel.xyz * weight;
+		 weight_sum += weight;
+	  }
+   }
+
+   // the centre tap always has a weight, so weight_sum is never zero
+   sum.xyz /= weight_sum;
+   sum.w = centre.w;
+
+   // write new pixel value to output
+   write_imagef(dst_image, (int2)(column, row), sum);
+}
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <cmath>
 
 // OpenCL header, depending on OS
 #ifdef __APPLE__
@@ -18,6 +19,13 @@
 
 #define NUM_ITERATIONS 1000
 
+// bilateral filter settings, must match BILATERAL_RADIUS, BILATERAL_TILE and RANGE_LEVELS in the kernel
+#define BILATERAL_RADIUS 3
+#define BILATERAL_TILE 16
+#define RANGE_LEVELS 256
+#define SIGMA_SPATIAL 2.0f		// in pixels
+#define SIGMA_RANGE 0.1f		// in mean channel difference, channels range from 0 to 1
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
@@ -30,14 +38,17 @@ int main(void)
 	// declare data and memory objects
 	unsigned char* inputImage;
 	unsigned char* outputImage;
-	int imgWidth, imgHeight, imageSize;
+	unsigned char* outputImageInt;
+	int imgWidth, imgHeight, imageSize, numMismatches;
 
-	cl::ImageFormat imgFormat;
+	cl::ImageFormat imgFormat, intFormat;
 	cl::Image2D inputImgBuffer, outputImgBuffer;
+	cl::Image2D inputIntBuffer, outputIntBuffer;
+	cl::Buffer spatialBuffer, rangeBuffer;
 
 	// declare events
 	cl::Event profileEvent;
-	cl_ulong timeStart, timeEnd, timeTotal;
+	cl_ulong timeStart, timeEnd, timeTotal, timeTotalInt, timeTotalBilateral;
 
 	try {
 		// select an OpenCL device
@@ -69,6 +80,7 @@ int main(void)
 		// allocate memory for output image
 		imageSize = imgWidth * imgHeight * 4;
 		outputImage = new unsigned char[imageSize];
+		outputImageInt = new unsigned char[imageSize];
 
 		// image format
 		imgFormat = cl::ImageFormat(CL_RGBA, CL_UNORM_INT8);
@@ -114,12 +126,121 @@ int main(void)
 
 		// print average time
 		std::cout << "Average execution time: " << timeTotal / NUM_ITERATIONS << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// integer path reads and writes unnormalised 8-bit channels
+		intFormat = cl::ImageFormat(CL_RGBA, CL_UNSIGNED_INT8);
+
+		inputIntBuffer = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, intFormat, imgWidth, imgHeight, 0, (void*)inputImage);
+		outputIntBuffer = cl::Image2D(context, CL_MEM_WRITE_ONLY, intFormat, imgWidth, imgHeight);
+
+		kernel = cl::Kernel(program, "gauss_conv_int");
+		kernel.setArg(0, inputIntBuffer);
+		kernel.setArg(1, outputIntBuffer);
+
+		timeTotalInt = 0;
+
+		for (int i = 0; i < NUM_ITERATIONS; i++)
+		{
+			queue.enqueueNDRangeKernel(kernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
+			queue.finish();
+
+			timeStart = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+			timeEnd = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+			timeTotalInt += timeEnd - timeStart;
+		}
+
+		std::cout << "Integer kernel enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		queue.enqueueReadImage(outputIntBuffer, CL_TRUE, origin, region, 0, 0, outputImageInt);
+
+		// output results to image file
+		write_BMP_RGBA_to_RGB("output_int.bmp", outputImageInt, imgWidth, imgHeight);
+
+		// the rounded integer weights differ slightly from GaussFilter
+		numMismatches = 0;
+		for (int i = 0; i < imageSize; i++)
+		{
+			if (abs(outputImage[i] - outputImageInt[i]) > 2 && i % 4 != 3)
+			{
+				numMismatches++;
+			}
+		}
+
+		// float conversion on every tap is expensive on CPU devices, where the gap is largest
+		std::cout << "Integer average execution time: " << timeTotalInt / NUM_ITERATIONS << std::endl;
+		std::cout << "Speedup over float: " << (double)timeTotal / timeTotalInt << std::endl;
+		std::cout << "Channels differing by more than 2: " << numMismatches << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// spatial weights for every tap of the window, the kernel normalises the total
+		const int filterWidth = 2 * BILATERAL_RADIUS + 1;
+		float spatialWeights[filterWidth * filterWidth];
+
+		for (int i = 0; i < filterWidth; i++)
+		{
+			for (int j = 0; j < filterWidth; j++)
+			{
+				float dy = (float)(i - BILATERAL_RADIUS);
+				float dx = (float)(j - BILATERAL_RADIUS);
+				spatialWeights[i * filterWidth + j] = expf(-(dx * dx + dy * dy) / (2.0f * SIGMA_SPATIAL * SIGMA_SPATIAL));
+			}
+		}
+
+		// range weights by quantised colour difference, replaces exp() on every tap
+		float rangeWeights[RANGE_LEVELS];
+
+		for (int i = 0; i < RANGE_LEVELS; i++)
+		{
+			float difference = (float)i / (RANGE_LEVELS - 1);
+			rangeWeights[i] = expf(-(difference * difference) / (2.0f * SIGMA_RANGE * SIGMA_RANGE));
+		}
+
+		spatialBuffer = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(spatialWeights), spatialWeights);
+		rangeBuffer = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(rangeWeights), rangeWeights);
+
+		kernel = cl::Kernel(program, "bilateral_conv");
+		kernel.setArg(0, inputImgBuffer);
+		kernel.setArg(1, outputImgBuffer);
+		kernel.setArg(2, spatialBuffer);
+		kernel.setArg(3, rangeBuffer);
+
+		// whole tiles, the kernel skips pixels past the edge
+		cl::NDRange tileSize(BILATERAL_TILE, BILATERAL_TILE);
+		cl::NDRange tiledSize((imgWidth + BILATERAL_TILE - 1) / BILATERAL_TILE * BILATERAL_TILE,
+			(imgHeight + BILATERAL_TILE - 1) / BILATERAL_TILE * BILATERAL_TILE);
+
+		timeTotalBilateral = 0;
+
+		for (int i = 0; i < NUM_ITERATIONS; i++)
+		{
+			queue.enqueueNDRangeKernel(kernel, offset, tiledSize, tileSize, NULL, &profileEvent);
+			queue.finish();
+
+			timeStart = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+			timeEnd = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+			timeTotalBilateral += timeEnd - timeStart;
+		}
+
+		std::cout << "Bilateral kernel enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
+
+		// output results to image file
+		write_BMP_RGBA_to_RGB("output_bilateral.bmp", outputImage, imgWidth, imgHeight);
+
+		std::cout << "Bilateral average execution time: " << timeTotalBilateral / NUM_ITERATIONS << std::endl;
 
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
 		free(inputImage);
 		free(outputImage);
+		delete[] outputImageInt;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {
@@ -5,6 +5,11 @@ __constant float Weights[7] = {
 	0.00598, 0.060626, 0.241843, 0.383103, 0.241843, 0.060626, 0.00598
 };
 
+// Weights scaled to 256 and rounded, a pass divides by 256 with a shift
+__constant uint IntWeights[7] = {
+	2, 16, 62, 96, 62, 16, 2
+};
+
 __kernel void task3b(read_only image2d_t src_image,
 						write_only image2d_t dst_image,
 						int pass_type) {
@@ -53,4 +58,78 @@ __kernel void task3b(read_only image2d_t src_image,
 	// write new pixel value to output
 	coord = (int2) (column, row);
 	write_imagef(dst_image, coord, sum);
-}
\ No newline at end of file
+}
+
+__kernel void task3b_int(read_only image2d_t src_image,
+						write_only image2d_t dst_image,
+						int pass_type) {
+
+	// get work-item's row and column position
+	int column = get_global_id(0);
+	int row = get_global_id(1);
+
+	// accumulated pixel value, no conversion to float on any tap
+	uint4 sum = (uint4)(0);
+
+	int2 coord = (int2)(column, row);
+
+	// iterate over the pixels
+	for (int i = -3; i <= 3; i++) {
+
+		// perform vertical pass
+		if (pass_type == 1) {
+			coord.y = row + i;
+		}
+		// perform horizontal pass
+		else {
+			coord.x = column + i;
+		}
+
+		// accumulate weighted sum
+		sum += read_imageui(src_image, sampler, coord) * IntWeights[i + 3];
+	}
+
+	coord = (int2)(column, row);
+
+	// Horizontal pass keeps the full 16-bit sum for the vertical pass
+	if (pass_type == 0) {
+		write_imageui(dst_image, coord, sum);
+	}
+	// Vertical pass divides by 256 * 256 with rounding
+	else {
+		sum = (sum + 32768) >> 16;
+		sum.w = 255;
+		write_imageui(dst_image, coord, sum);
+	}
+}
+
+__kernel void task3b_unsharp(read_only image2d_t src_image_blur_horz,
+						read_only image2d_t src_image,
+						write_only image2d_t dst_image,
+						float amount,
+						float threshold) {
+
+	// get work-item's row and column position
+	int column = get_global_id(0);
+	int row = get_global_id(1);
+
+	// vertical blur pass over the horizontally blurred image
+	float4 blur = (float4)(0.0);
+
+	for (int i = -3; i <= 3; i++) {
+		blur.xyz += read_imagef(src_image_blur_horz, sampler, (int2)(column, row + i)).xyz * Weights[i + 3];
+	}
+
+	// sharpen with the detail removed by the blur, fused into the same pass
+	int2 coord = (int2)(column, row);
+	float4 pixel = read_imagef(src_image, sampler, coord);
+	float4 detail = pixel - blur;
+
+	// differences below the threshold are treated as noise and left alone
+	int4 mask = isgreater(fabs(detail), (float4)(threshold));
+	mask.w = 0;
+	pixel = select(pixel, clamp(pixel + amount * detail, 0.0f, 1.0f), mask);
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, pixel);
+}
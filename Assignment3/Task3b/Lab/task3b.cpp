@@ -18,6 +18,10 @@
 
 #define NUM_ITERATIONS 1000
 
+// unsharp mask, out = in + amount * (in - blur) where the difference exceeds the threshold
+#define UNSHARP_AMOUNT 1.5f
+#define UNSHARP_THRESHOLD 0.02f
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
@@ -30,14 +34,17 @@ int main(void)
 	// declare data and memory objects
 	unsigned char* inputImage;
 	unsigned char* outputImage;
-	int imgWidth, imgHeight, imageSize;
+	unsigned char* outputImageInt;
+	int imgWidth, imgHeight, imageSize, numMismatches;
 
-	cl::ImageFormat imgFormat;
+	cl::ImageFormat imgFormat, intFormat, sumFormat;
 	cl::Image2D inputImgBuffer, outputImgBuffer;
+	cl::Image2D inputIntBuffer, sumIntBuffer, outputIntBuffer;
+	cl::Image2D sourceImgBuffer, blurHorzBuffer;
 
 	// declare events
 	cl::Event profileEvent;
-	cl_ulong timeStart, timeEnd, timeTotal;
+	cl_ulong timeStart, timeEnd, timeTotal, timeTotalInt, timeTotalUnsharp;
 
 	try {
 		// select an OpenCL device
@@ -69,6 +76,7 @@ int main(void)
 		// allocate memory for output image
 		imageSize = imgWidth * imgHeight * 4;
 		outputImage = new unsigned char[imageSize];
+		outputImageInt = new unsigned char[imageSize];
 
 		// image format
 		imgFormat = cl::ImageFormat(CL_RGBA, CL_UNORM_INT8);
@@ -141,12 +149,111 @@ int main(void)
 
 		// output average execution time
 		std::cout << "Average execution time: " << timeTotal / NUM_ITERATIONS << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// integer path, unnormalised 8-bit input and output with a 16-bit intermediate
+		intFormat = cl::ImageFormat(CL_RGBA, CL_UNSIGNED_INT8);
+		sumFormat = cl::ImageFormat(CL_RGBA, CL_UNSIGNED_INT16);
+
+		inputIntBuffer = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, intFormat, imgWidth, imgHeight, 0, (void*)inputImage);
+		sumIntBuffer = cl::Image2D(context, CL_MEM_READ_WRITE, sumFormat, imgWidth, imgHeight);
+		outputIntBuffer = cl::Image2D(context, CL_MEM_WRITE_ONLY, intFormat, imgWidth, imgHeight);
+
+		kernel = cl::Kernel(program, "task3b_int");
+		timeTotalInt = 0;
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			// horizontal pass into the 16-bit sums, vertical pass back to 8 bits
+			kernel.setArg(0, pass == 0 ? inputIntBuffer : sumIntBuffer);
+			kernel.setArg(1, pass == 0 ? sumIntBuffer : outputIntBuffer);
+			kernel.setArg(2, pass);
+
+			for (int i = 0; i < NUM_ITERATIONS; i++)
+			{
+				queue.enqueueNDRangeKernel(kernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
+				queue.finish();
+
+				timeStart = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+				timeEnd = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+				timeTotalInt += timeEnd - timeStart;
+			}
+		}
+
+		std::cout << "Integer kernels enqueued for both passes." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		queue.enqueueReadImage(outputIntBuffer, CL_TRUE, origin, region, 0, 0, outputImageInt);
+
+		// output results to image file
+		write_BMP_RGBA_to_RGB("output_int.bmp", outputImageInt, imgWidth, imgHeight);
+
+		// rounded weights and the 8-bit intermediate of the float path give small differences
+		numMismatches = 0;
+		for (int i = 0; i < imageSize; i++)
+		{
+			if (abs(outputImage[i] - outputImageInt[i]) > 2 && i % 4 != 3)
+			{
+				numMismatches++;
+			}
+		}
+
+		// float conversion on every tap is expensive on CPU devices, where the gap is largest
+		std::cout << "Integer average execution time: " << timeTotalInt / NUM_ITERATIONS << std::endl;
+		std::cout << "Speedup over float: " << (double)timeTotal / timeTotalInt << std::endl;
+		std::cout << "Channels differing by more than 2: " << numMismatches << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// unsharp mask, the horizontal blur stays on the device as floats
+		sourceImgBuffer = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)inputImage);
+		blurHorzBuffer = cl::Image2D(context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_FLOAT), imgWidth, imgHeight);
+
+		cl::Kernel horzKernel(program, "task3b");
+		horzKernel.setArg(0, sourceImgBuffer);
+		horzKernel.setArg(1, blurHorzBuffer);
+		horzKernel.setArg(2, 0);
+
+		// vertical pass also subtracts the blur and adds the scaled detail
+		kernel = cl::Kernel(program, "task3b_unsharp");
+		kernel.setArg(0, blurHorzBuffer);
+		kernel.setArg(1, sourceImgBuffer);
+		kernel.setArg(2, outputImgBuffer);
+		kernel.setArg(3, UNSHARP_AMOUNT);
+		kernel.setArg(4, UNSHARP_THRESHOLD);
+
+		timeTotalUnsharp = 0;
+
+		for (int i = 0; i < NUM_ITERATIONS; i++)
+		{
+			queue.enqueueNDRangeKernel(horzKernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
+			queue.finish();
+
+			timeTotalUnsharp += profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>() - profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+
+			queue.enqueueNDRangeKernel(kernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
+			queue.finish();
+
+			timeTotalUnsharp += profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>() - profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+		}
+
+		std::cout << "Unsharp mask kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
+
+		// output results to image file
+		write_BMP_RGBA_to_RGB("output_sharp.bmp", outputImage, imgWidth, imgHeight);
+
+		// costs the same two passes as the blur
+		std::cout << "Unsharp mask average execution time: " << timeTotalUnsharp / NUM_ITERATIONS << std::endl;
 
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
 		free(inputImage);
 		free(outputImage);
+		delete[] outputImageInt;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {
@@ -12,17 +12,64 @@ __constant float GaussFilter[49] = {
 	0.000036, 0.000363, 0.001446, 0.002291, 0.001446, 0.000363, 0.000036
 };
 
+// mappings from the 1D global ID to pixels
+#define MAPPING_ROW_MAJOR 0
+#define MAPPING_TILED 1
+#define MAPPING_MORTON 2
+
+// width and height of a block for the tiled and Morton mappings, must be a power of two
+#define MAP_TILE_SIZE 16
+
+// extracts the even bits of v, used to decode a Morton (Z-order) index
+int compact_bits(int v) {
+   v &= 0x55555555;
+   v = (v | (v >> 1)) & 0x33333333;
+   v = (v | (v >> 2)) & 0x0F0F0F0F;
+   v = (v | (v >> 4)) & 0x00FF00FF;
+   v = (v | (v >> 8)) & 0x0000FFFF;
+   return v;
+}
+
 __kernel void task3c(read_only image2d_t src_image,
-					write_only image2d_t dst_image) {
+					write_only image2d_t dst_image,
+					int mapping) {
 
 	// get image dimensions
 	int2 dim = get_image_dim(src_image);
 
    // get work-item’s row and column position
    int id = get_global_id(0);
-   int column = id % dim.x;
-   int row = id / dim.y;
-   // printf("(%d, %d)\n", column, row);
+   int column, row;
+
+   if(mapping == MAPPING_ROW_MAJOR) {
+      column = id % dim.x;
+      row = id / dim.x;
+   }
+   else {
+      // blocks of MAP_TILE_SIZE x MAP_TILE_SIZE pixels, visited row by row
+      int tiles_per_row = (dim.x + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
+      int tile = id / (MAP_TILE_SIZE * MAP_TILE_SIZE);
+      int index = id % (MAP_TILE_SIZE * MAP_TILE_SIZE);
+      int tx, ty;
+
+      // row-major inside the block
+      if(mapping == MAPPING_TILED) {
+         tx = index % MAP_TILE_SIZE;
+         ty = index / MAP_TILE_SIZE;
+      }
+      // Z-order inside the block, x in the even bits and y in the odd bits
+      else {
+         tx = compact_bits(index);
+         ty = compact_bits(index >> 1);
+      }
+
+      column = (tile % tiles_per_row) * MAP_TILE_SIZE + tx;
+      row = (tile / tiles_per_row) * MAP_TILE_SIZE + ty;
+   }
+
+   // blocks are padded at the right and bottom edges
+   if(column >= dim.x || row >= dim.y)
+      return;
 
    // accumulated pixel value
    float4 sum = (float4)(0.0);
@@ -49,6 +96,9 @@ __kernel void task3c(read_only image2d_t src_image,
 	  }
    }
 
+   // written pixels are opaque, the host counts pixels left transparent as uncovered
+   sum.w = 1.0f;
+
    // write new pixel value to output
    coord = (int2)(column, row); 
    write_imagef(dst_image, coord, sum);
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <cstring>
 
 // OpenCL header, depending on OS
 #ifdef __APPLE__
@@ -17,6 +18,12 @@
 #include "bmpfuncs.h"
 
 #define NUM_ITERATIONS 1000
+#define MAP_TILE_SIZE 16		// must match MAP_TILE_SIZE in task3c.cl
+
+// mappings from the 1D global ID to pixels, same values as in task3c.cl
+enum Mappings {ROW_MAJOR, TILED, MORTON, NUM_MAPPINGS};
+
+const char* mappingNames[NUM_MAPPINGS] = { "Row-major", "Tiled", "Morton" };
 
 int main(void) 
 {
@@ -30,7 +37,10 @@ int main(void)
 	// declare data and memory objects
 	unsigned char* inputImage;
 	unsigned char* outputImage;
-	int imgWidth, imgHeight, imageSize;
+	unsigned char* referenceImage;
+	unsigned char* sentinelImage;
+	int imgWidth, imgHeight, imageSize, numMismatches, numUncovered;
+	int tilesX, tilesY;
 
 	cl::ImageFormat imgFormat;
 	cl::Image2D inputImgBuffer, outputImgBuffer;
@@ -62,6 +72,11 @@ int main(void)
 
 		// create command queue
 		queue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
+
+		// the cache size puts the differences between mappings in context
+		std::cout << "Device: " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+		std::cout << "Global memory cache size: " << device.getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_SIZE>() << std::endl;
+		std::cout << "--------------------" << std::endl;
 		
 		// read input image
 		inputImage = read_BMP_RGB_to_RGBA("peppers.bmp", &imgWidth, &imgHeight);
@@ -69,6 +84,11 @@ int main(void)
 		// allocate memory for output image
 		imageSize = imgWidth * imgHeight * 4;
 		outputImage = new unsigned char[imageSize];
+		referenceImage = new unsigned char[imageSize];
+
+		// the kernel writes an opaque alpha, so a zero alpha marks a pixel no work-item reached
+		sentinelImage = new unsigned char[imageSize];
+		memset(sentinelImage, 0, imageSize);
 
 		// image format
 		imgFormat = cl::ImageFormat(CL_RGBA, CL_UNORM_INT8);
@@ -80,46 +100,89 @@ int main(void)
 		// set kernel arguments
 		kernel.setArg(0, inputImgBuffer);
 		kernel.setArg(1, outputImgBuffer);
-		
-		// enqueue kernel
-		cl::NDRange offset(0, 0);
-		cl::NDRange globalSize(imgWidth * imgHeight);
-		timeTotal = 0;
-
-		for (int i = 0; i < NUM_ITERATIONS; i++)
-		{
-			queue.enqueueNDRangeKernel(kernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
-			queue.finish();
 
-			timeStart = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
-			timeEnd = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
-
-			timeTotal += timeEnd - timeStart;
-		}
-
-		std::cout << "Kernel enqueued." << std::endl;
-		std::cout << "--------------------" << std::endl;
-
-		// enqueue command to read image from device to host memory
+		// image region to read back
 		cl::size_t<3> origin, region;
 		origin[0] = origin[1] = origin[2] = 0;
 		region[0] = imgWidth;
 		region[1] = imgHeight;
 		region[2] = 1;
 
-		queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
+		// tiled mappings cover whole blocks, padded past the image edges
+		tilesX = (imgWidth + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
+		tilesY = (imgHeight + MAP_TILE_SIZE - 1) / MAP_TILE_SIZE;
 
-		// output results to image file
-		write_BMP_RGBA_to_RGB("output.bmp", outputImage, imgWidth, imgHeight);
+		cl::NDRange offset(0);
 
-		// output average execution time
-		std::cout << "Average execution time: " << timeTotal / NUM_ITERATIONS << std::endl;
+		for (int m = 0; m < NUM_MAPPINGS; m++)
+		{
+			cl::NDRange globalSize(m == ROW_MAJOR ? imgWidth * imgHeight : tilesX * tilesY * MAP_TILE_SIZE * MAP_TILE_SIZE);
+
+			kernel.setArg(2, m);
+			timeTotal = 0;
+
+			// clear the output so pixels left over from the previous mapping are not counted as covered
+			queue.enqueueWriteImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, sentinelImage);
+
+			// enqueue kernel
+			for (int i = 0; i < NUM_ITERATIONS; i++)
+			{
+				queue.enqueueNDRangeKernel(kernel, offset, globalSize, cl::NullRange, NULL, &profileEvent);
+				queue.finish();
+
+				timeStart = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+				timeEnd = profileEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+
+				timeTotal += timeEnd - timeStart;
+			}
+
+			// enqueue command to read image from device to host memory
+			queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
+
+			// every mapping must produce the same image as row-major
+			numMismatches = 0;
+			numUncovered = 0;
+
+			for (int i = 3; i < imageSize; i += 4)
+			{
+				if (outputImage[i] == 0)
+				{
+					numUncovered++;
+				}
+			}
+
+			if (m == ROW_MAJOR)
+			{
+				memcpy(referenceImage, outputImage, imageSize);
+
+				// output results to image file
+				write_BMP_RGBA_to_RGB("output.bmp", outputImage, imgWidth, imgHeight);
+			}
+			else
+			{
+				for (int i = 0; i < imageSize; i++)
+				{
+					if (outputImage[i] != referenceImage[i])
+					{
+						numMismatches++;
+					}
+				}
+			}
+
+			// output average execution time
+			std::cout << mappingNames[m] << " mapping average execution time: " << timeTotal / NUM_ITERATIONS;
+			std::cout << ", mismatches: " << numMismatches;
+			std::cout << ", uncovered pixels: " << numUncovered << std::endl;
+		}
 
+		std::cout << "--------------------" << std::endl;
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
 		free(inputImage);
 		free(outputImage);
+		delete[] referenceImage;
+		delete[] sentinelImage;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {
@@ -0,0 +1,740 @@
+#include <cmath>
+#include <climits>
+
+#include "bloom.h"
+
+// returns the image format for intermediate results, half floats halve the memory traffic
+cl::ImageFormat intermediate_format(bool halfFloat)
+{
+	return cl::ImageFormat(CL_RGBA, halfFloat ? CL_HALF_FLOAT : CL_FLOAT);
+}
+
+// blurs the source image by downsampling it through a chain of half-resolution images,
+// then upsampling and accumulating back up the chain into the destination image
+void mip_chain_blur(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int levels, int skipLevels,
+	bool halfFloat, Region roi)
+{
+	// intermediate levels are kept as floats so the accumulated glow is not clamped
+	cl::ImageFormat levelFormat = intermediate_format(halfFloat);
+
+	std::vector<cl::Image2D> downLevels(levels + 1);	// downsampled images, level 0 is the source
+	std::vector<int> levelWidth(levels + 1), levelHeight(levels + 1);
+
+	cl::Kernel downKernel(*prog, "mip_downsample");
+	cl::Kernel upKernel(*prog, "mip_upsample");
+	cl::NDRange offset(0, 0);
+
+	// compute the size of each level
+	levelWidth[0] = width;
+	levelHeight[0] = height;
+	downLevels[0] = *srcImage;
+
+	for (int i = 1; i <= levels; i++)
+	{
+		levelWidth[i] = levelWidth[i - 1] > 1 ? levelWidth[i - 1] / 2 : 1;
+		levelHeight[i] = levelHeight[i - 1] > 1 ? levelHeight[i - 1] / 2 : 1;
+	}
+
+	// downsample through the chain, each level reads the one above it
+	for (int i = 1; i <= levels; i++)
+	{
+		downLevels[i] = cl::Image2D(*ctx, CL_MEM_READ_WRITE, levelFormat, levelWidth[i], levelHeight[i]);
+
+		downKernel.setArg(0, downLevels[i - 1]);
+		downKernel.setArg(1, downLevels[i]);
+
+		queue->enqueueNDRangeKernel(downKernel, offset, cl::NDRange(levelWidth[i], levelHeight[i]));
+	}
+
+	// upsample back up the chain, adding each level to the upsampled level below it
+	cl::Image2D lowerLevel = downLevels[levels];
+
+	for (int i = levels - 1; i >= 0; i--)
+	{
+		cl::Image2D upLevel;
+		cl_float scale = 1.0f;
+
+		if (i == 0)
+		{
+			// average the accumulated levels into the destination image
+			upLevel = *dstImage;
+			scale = 1.0f / (levels + 1 - skipLevels);
+		}
+		else
+		{
+			upLevel = cl::Image2D(*ctx, CL_MEM_READ_WRITE, levelFormat, levelWidth[i], levelHeight[i]);
+		}
+
+		upKernel.setArg(0, lowerLevel);
+		upKernel.setArg(1, downLevels[i]);
+		upKernel.setArg(2, upLevel);
+		upKernel.setArg(3, i < skipLevels ? 0.0f : 1.0f);
+		upKernel.setArg(4, scale);
+
+		// the final level only covers the roi, the lower levels are a fraction of its cost
+		if (i == 0)
+			enqueue_region(queue, &upKernel, roi);
+		else
+			queue->enqueueNDRangeKernel(upKernel, offset, cl::NDRange(levelWidth[i], levelHeight[i]));
+
+		lowerLevel = upLevel;
+	}
+}
+
+// computes the Young-van Vliet recursive Gaussian coefficients for sigma,
+// returned as (B, b1/b0, b2/b0, b3/b0)
+cl_float4 recursive_gaussian_coefficients(float sigma)
+{
+	cl_float4 coefficients;
+	float q, b0, b1, b2, b3;
+
+	// the approximation is only valid from sigma 0.5 upwards
+	if (sigma < 0.5f)
+		sigma = 0.5f;
+
+	if (sigma >= 2.5f)
+		q = 0.98711f * sigma - 0.96330f;
+	else
+		q = 3.97156f - 4.14554f * sqrtf(1.0f - 0.26891f * sigma);
+
+	b0 = 1.57825f + 2.44413f * q + 1.4281f * q * q + 0.422205f * q * q * q;
+	b1 = 2.44413f * q + 2.85619f * q * q + 1.26661f * q * q * q;
+	b2 = -(1.4281f * q * q + 1.26661f * q * q * q);
+	b3 = 0.422205f * q * q * q;
+
+	coefficients.s[0] = 1.0f - (b1 + b2 + b3) / b0;
+	coefficients.s[1] = b1 / b0;
+	coefficients.s[2] = b2 / b0;
+	coefficients.s[3] = b3 / b0;
+
+	return coefficients;
+}
+
+// blurs the source image with a recursive Gaussian, one row then one column per work-item,
+// cost per pixel does not depend on sigma
+void recursive_gaussian_blur(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, float sigma, bool halfFloat)
+{
+	cl_float4 coefficients = recursive_gaussian_coefficients(sigma);
+
+	// horizontal pass output is kept as floats for the vertical pass
+	cl::Image2D horzImage(*ctx, CL_MEM_READ_WRITE, intermediate_format(halfFloat), width, height);
+
+	// causal results are held here until the anticausal filter consumes them
+	size_t scratchSize = (halfFloat ? sizeof(cl_half) : sizeof(cl_float)) * 4 * width * height;
+	cl::Buffer scratchBuffer(*ctx, CL_MEM_READ_WRITE, scratchSize);
+
+	cl::Kernel kernel(*prog, "iir_blur_pass");
+	cl::NDRange offset(0);
+
+	// horizontal pass, one work-item per row
+	kernel.setArg(0, *srcImage);
+	kernel.setArg(1, horzImage);
+	kernel.setArg(2, 0);
+	kernel.setArg(3, coefficients);
+	kernel.setArg(4, scratchBuffer);
+	kernel.setArg(5, halfFloat ? 1 : 0);
+
+	queue->enqueueNDRangeKernel(kernel, offset, cl::NDRange(height));
+
+	// vertical pass, one work-item per column
+	kernel.setArg(0, horzImage);
+	kernel.setArg(1, *dstImage);
+	kernel.setArg(2, 1);
+
+	queue->enqueueNDRangeKernel(kernel, offset, cl::NDRange(width));
+}
+
+// builds a summed-area table of the source image into satBuffer (width * height float4s),
+// luminance tables hold the luminance and its square instead of RGBA
+void build_summed_area_table(const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Buffer* satBuffer, int width, int height, bool luminance)
+{
+	cl::Kernel rowKernel(*prog, "sat_row_scan");
+	cl::Kernel columnKernel(*prog, "sat_column_scan");
+	cl::NDRange offset(0);
+
+	// scan each row, one work-item per row
+	rowKernel.setArg(0, *srcImage);
+	rowKernel.setArg(1, *satBuffer);
+	rowKernel.setArg(2, luminance ? 1 : 0);
+
+	queue->enqueueNDRangeKernel(rowKernel, offset, cl::NDRange(height));
+
+	// scan each column of the row sums, one work-item per column
+	columnKernel.setArg(0, *satBuffer);
+	columnKernel.setArg(1, width);
+	columnKernel.setArg(2, height);
+
+	queue->enqueueNDRangeKernel(columnKernel, offset, cl::NDRange(width));
+}
+
+// box blurs the source image over a window of the given radius at constant cost per pixel
+void box_blur(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int radius, Region roi)
+{
+	cl::Buffer satBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_float4) * width * height);
+	cl::Kernel kernel(*prog, "box_blur");
+
+	build_summed_area_table(queue, prog, srcImage, &satBuffer, width, height, false);
+
+	kernel.setArg(0, satBuffer);
+	kernel.setArg(1, radius);
+	kernel.setArg(2, *dstImage);
+
+	enqueue_region(queue, &kernel, roi);
+}
+
+// keeps the luminance of pixels above both the threshold and mean + k * deviation of their neighbourhood
+void adaptive_glowing_pixels(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height,
+	float threshold, int radius, float k, Region roi)
+{
+	cl::Buffer satBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_float4) * width * height);
+	cl::Kernel kernel(*prog, "adaptive_glowing_pixels");
+
+	build_summed_area_table(queue, prog, srcImage, &satBuffer, width, height, true);
+
+	kernel.setArg(0, *srcImage);
+	kernel.setArg(1, satBuffer);
+	kernel.setArg(2, threshold);
+	kernel.setArg(3, radius);
+	kernel.setArg(4, k);
+	kernel.setArg(5, *dstImage);
+
+	enqueue_region(queue, &kernel, roi);
+}
+
+// computes an Otsu threshold from a luminance histogram of the source image into thresholdBuffer
+void otsu_threshold(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Buffer* thresholdBuffer, int width, int height)
+{
+	const int numBins = 256;		// must match HISTOGRAM_BINS in the kernel
+	const int groupSize = 16;		// work-group width and height for the histogram
+
+	cl::Buffer histogramBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_uint) * numBins);
+
+	cl::Kernel histogramKernel(*prog, "luminance_histogram");
+	cl::Kernel otsuKernel(*prog, "otsu_threshold");
+
+	// clear the global histogram
+	queue->enqueueFillBuffer(histogramBuffer, (cl_uint)0, 0, sizeof(cl_uint) * numBins);
+
+	// build the histogram, global size rounded up to whole work-groups
+	histogramKernel.setArg(0, *srcImage);
+	histogramKernel.setArg(1, histogramBuffer);
+
+	cl::NDRange globalSize((width + groupSize - 1) / groupSize * groupSize, (height + groupSize - 1) / groupSize * groupSize);
+	queue->enqueueNDRangeKernel(histogramKernel, cl::NDRange(0, 0), globalSize, cl::NDRange(groupSize, groupSize));
+
+	// compute the threshold with a single work-item
+	otsuKernel.setArg(0, histogramBuffer);
+	otsuKernel.setArg(1, *thresholdBuffer);
+
+	queue->enqueueTask(otsuKernel);
+}
+
+// keeps the luminance of pixels above an Otsu threshold computed from a luminance histogram,
+// the threshold never leaves the device
+void otsu_glowing_pixels(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, Region roi)
+{
+	cl::Buffer thresholdBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_float));
+	cl::Kernel thresholdKernel(*prog, "glowing_pixels_auto");
+
+	otsu_threshold(ctx, queue, prog, srcImage, &thresholdBuffer, width, height);
+
+	// threshold the image, in-order queue so no host synchronisation is needed
+	thresholdKernel.setArg(0, *srcImage);
+	thresholdKernel.setArg(1, thresholdBuffer);
+	thresholdKernel.setArg(2, *dstImage);
+
+	enqueue_region(queue, &thresholdKernel, roi);
+}
+
+// region covering the whole image
+Region full_region(int width, int height)
+{
+	Region region;
+
+	region.x = region.y = 0;
+	region.width = width;
+	region.height = height;
+
+	return region;
+}
+
+// grows the region by haloX and haloY pixels on each side, clipped to the image
+Region expand_region(Region region, int haloX, int haloY, int width, int height)
+{
+	Region expanded;
+
+	expanded.x = region.x - haloX > 0 ? region.x - haloX : 0;
+	expanded.y = region.y - haloY > 0 ? region.y - haloY : 0;
+	expanded.width = (region.x + region.width + haloX < width ? region.x + region.width + haloX : width) - expanded.x;
+	expanded.height = (region.y + region.height + haloY < height ? region.y + region.height + haloY : height) - expanded.y;
+
+	return expanded;
+}
+
+// enqueues a 2D kernel over the pixels of the region using a global offset
+void enqueue_region(const cl::CommandQueue* queue, const cl::Kernel* kernel, Region region)
+{
+	// nothing to do for an empty region
+	if (region.width <= 0 || region.height <= 0)
+		return;
+
+	// kernels take their pixel coordinate from the global ID, which includes the offset
+	queue->enqueueNDRangeKernel(*kernel, cl::NDRange(region.x, region.y), cl::NDRange(region.width, region.height));
+}
+
+// creates the cached images and threshold buffer for the separable bloom pipeline
+void create_bloom_cache(const cl::Context* ctx, BloomCache* cache, int width, int height)
+{
+	cl::ImageFormat format(CL_RGBA, CL_UNORM_INT8);
+
+	cache->glow = cl::Image2D(*ctx, CL_MEM_READ_WRITE, format, width, height);
+	cache->blurHorz = cl::Image2D(*ctx, CL_MEM_READ_WRITE, format, width, height);
+	cache->blur = cl::Image2D(*ctx, CL_MEM_READ_WRITE, format, width, height);
+	cache->output = cl::Image2D(*ctx, CL_MEM_READ_WRITE, format, width, height);
+	cache->threshold = cl::Buffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_float));
+	cache->width = width;
+	cache->height = height;
+}
+
+// reruns glowing pixels, both blur passes and bloom only over the pixels affected by
+// the dirty region of the source image, other pixels keep their cached results
+void update_bloom_region(const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, BloomCache* cache, Region dirty)
+{
+	const int blurRadius = 3;		// blur_pass reads 3 pixels either side
+
+	cl::Kernel thresholdKernel(*prog, "glowing_pixels_auto");
+	cl::Kernel blurKernel(*prog, "blur_pass");
+	cl::Kernel bloomKernel(*prog, "bloom");
+
+	// glowing pixels only change inside the dirty region
+	thresholdKernel.setArg(0, *srcImage);
+	thresholdKernel.setArg(1, cache->threshold);
+	thresholdKernel.setArg(2, cache->glow);
+
+	enqueue_region(queue, &thresholdKernel, expand_region(dirty, 0, 0, cache->width, cache->height));
+
+	// horizontal pass spreads the change by the blur radius along rows
+	blurKernel.setArg(0, cache->glow);
+	blurKernel.setArg(1, cache->blurHorz);
+	blurKernel.setArg(2, 0);
+
+	enqueue_region(queue, &blurKernel, expand_region(dirty, blurRadius, 0, cache->width, cache->height));
+
+	// vertical pass spreads it along columns as well
+	blurKernel.setArg(0, cache->blurHorz);
+	blurKernel.setArg(1, cache->blur);
+	blurKernel.setArg(2, 1);
+
+	enqueue_region(queue, &blurKernel, expand_region(dirty, blurRadius, blurRadius, cache->width, cache->height));
+
+	// bloom is per pixel, so it covers the same pixels as the blurred result
+	bloomKernel.setArg(0, *srcImage);
+	bloomKernel.setArg(1, cache->blur);
+	bloomKernel.setArg(2, cache->output);
+
+	enqueue_region(queue, &bloomKernel, expand_region(dirty, blurRadius, blurRadius, cache->width, cache->height));
+}
+
+// one horizontal and one vertical min/max pass, the source is only read by the first pass
+static void morph_separable(const cl::CommandQueue* queue, cl::Kernel* kernel,
+	const cl::Image2D* srcImage, const cl::Image2D* tempImage, const cl::Image2D* dstImage,
+	int width, int height, int radius, int dilate)
+{
+	const int tileSize = 64;		// must match MORPH_TILE in the kernel
+
+	// work-groups cover whole tiles along the pass, the kernel skips pixels past the edge
+	int tilesX = (width + tileSize - 1) / tileSize;
+	int tilesY = (height + tileSize - 1) / tileSize;
+
+	kernel->setArg(2, radius);
+	kernel->setArg(4, dilate);
+
+	// horizontal pass, one work-group per row segment
+	kernel->setArg(0, *srcImage);
+	kernel->setArg(1, *tempImage);
+	kernel->setArg(3, 0);
+
+	queue->enqueueNDRangeKernel(*kernel, cl::NDRange(0, 0), cl::NDRange(tilesX * tileSize, height), cl::NDRange(tileSize, 1));
+
+	// vertical pass, one work-group per column segment
+	kernel->setArg(0, *tempImage);
+	kernel->setArg(1, *dstImage);
+	kernel->setArg(3, 1);
+
+	queue->enqueueNDRangeKernel(*kernel, cl::NDRange(0, 0), cl::NDRange(width, tilesY * tileSize), cl::NDRange(1, tileSize));
+}
+
+// applies a square structuring element of the given radius (at most 32) with separable
+// van Herk/Gil-Werman passes, cost per pixel does not depend on the radius,
+// srcImage and dstImage may be the same image
+void morphology(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int radius, MorphOperation operation)
+{
+	const int maxRadius = 32;		// must match MAX_MORPH_RADIUS in the kernel
+
+	if (radius > maxRadius)
+		radius = maxRadius;
+
+	cl::ImageFormat format(CL_RGBA, CL_UNORM_INT8);
+	cl::Image2D tempImage(*ctx, CL_MEM_READ_WRITE, format, width, height);
+	cl::Kernel kernel(*prog, "morph_pass");
+
+	switch (operation) {
+	case MORPH_ERODE:
+		morph_separable(queue, &kernel, srcImage, &tempImage, dstImage, width, height, radius, 0);
+		break;
+	case MORPH_DILATE:
+		morph_separable(queue, &kernel, srcImage, &tempImage, dstImage, width, height, radius, 1);
+		break;
+	default:
+		{
+			// opening erodes then dilates, closing dilates then erodes
+			int first = operation == MORPH_CLOSE ? 1 : 0;
+			cl::Image2D midImage(*ctx, CL_MEM_READ_WRITE, format, width, height);
+
+			morph_separable(queue, &kernel, srcImage, &tempImage, &midImage, width, height, radius, first);
+			morph_separable(queue, &kernel, &midImage, &tempImage, dstImage, width, height, radius, 1 - first);
+		}
+		break;
+	}
+}
+
+// labels the 8-connected bright regions of the mask with union-find on the device and
+// reduces their statistics into stats, returns the number of components found,
+// only the first maxComponents are measured
+int label_components(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* maskImage, int width, int height, ComponentStats* stats, int maxComponents)
+{
+	cl_uint numComponents = 0;
+	cl::NDRange offset(0, 0);
+	cl::NDRange globalSize(width, height);
+
+	cl::Buffer labelBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_int) * width * height);
+	cl::Buffer componentIdBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_int) * width * height);
+	cl::Buffer countBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_uint));
+	cl::Buffer statsBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(ComponentStats) * maxComponents);
+
+	cl::Kernel initKernel(*prog, "ccl_init");
+	cl::Kernel mergeKernel(*prog, "ccl_merge");
+	cl::Kernel compressKernel(*prog, "ccl_compress");
+	cl::Kernel statsKernel(*prog, "ccl_statistics");
+
+	// empty components so that the atomics can fold into them
+	for (int i = 0; i < maxComponents; i++) {
+		stats[i].area = 0;
+		stats[i].minX = stats[i].minY = INT_MAX;
+		stats[i].maxX = stats[i].maxY = -1;
+		stats[i].lumSum = 0;
+	}
+
+	queue->enqueueWriteBuffer(statsBuffer, CL_FALSE, 0, sizeof(ComponentStats) * maxComponents, stats);
+	queue->enqueueFillBuffer(countBuffer, 0, 0, sizeof(cl_uint));
+
+	// every bright pixel starts with its own label
+	initKernel.setArg(0, *maskImage);
+	initKernel.setArg(1, labelBuffer);
+
+	queue->enqueueNDRangeKernel(initKernel, offset, globalSize);
+
+	// join neighbouring labels, the atomic unions complete in a single launch
+	mergeKernel.setArg(0, labelBuffer);
+	mergeKernel.setArg(1, width);
+	mergeKernel.setArg(2, height);
+
+	queue->enqueueNDRangeKernel(mergeKernel, offset, globalSize);
+
+	// number the roots and flatten the trees
+	compressKernel.setArg(0, labelBuffer);
+	compressKernel.setArg(1, componentIdBuffer);
+	compressKernel.setArg(2, countBuffer);
+	compressKernel.setArg(3, width);
+	compressKernel.setArg(4, height);
+
+	queue->enqueueNDRangeKernel(compressKernel, offset, globalSize);
+
+	// area, bounding box and luminance per component
+	statsKernel.setArg(0, *maskImage);
+	statsKernel.setArg(1, labelBuffer);
+	statsKernel.setArg(2, componentIdBuffer);
+	statsKernel.setArg(3, statsBuffer);
+	statsKernel.setArg(4, width);
+	statsKernel.setArg(5, height);
+	statsKernel.setArg(6, maxComponents);
+
+	queue->enqueueNDRangeKernel(statsKernel, offset, globalSize);
+
+	// only the count and the statistics leave the device
+	queue->enqueueReadBuffer(countBuffer, CL_TRUE, 0, sizeof(cl_uint), &numComponents);
+	queue->enqueueReadBuffer(statsBuffer, CL_TRUE, 0, sizeof(ComponentStats) * maxComponents, stats);
+
+	return (int)numComponents;
+}
+
+// Lanczos-3 window, sinc(x) * sinc(x / 3) inside three lobes
+static float lanczos3(float x)
+{
+	const float pi = 3.14159265f;
+
+	if (x == 0.0f)
+		return 1.0f;
+	if (x <= -3.0f || x >= 3.0f)
+		return 0.0f;
+
+	return 3.0f * sinf(pi * x) * sinf(pi * x / 3.0f) / (pi * pi * x * x);
+}
+
+// computes the first source pixel and the normalised weights of every destination pixel
+// along one axis, returns the number of taps per destination pixel
+static int lanczos_weights(int srcSize, int dstSize, std::vector<float>* weights, std::vector<int>* first)
+{
+	float scale = (float)srcSize / dstSize;
+
+	// when shrinking, the window is stretched to cover every source pixel
+	float filterScale = scale > 1.0f ? scale : 1.0f;
+	float support = 3.0f * filterScale;
+	int taps = (int)ceilf(support) * 2 + 1;
+
+	weights->resize(dstSize * taps);
+	first->resize(dstSize);
+
+	for (int i = 0; i < dstSize; i++) {
+		float centre = (i + 0.5f) * scale;
+		int start = (int)floorf(centre - support);
+		float sum = 0.0f;
+
+		for (int k = 0; k < taps; k++) {
+			float weight = lanczos3((start + k + 0.5f - centre) / filterScale);
+			(*weights)[i * taps + k] = weight;
+			sum += weight;
+		}
+
+		// weights add up to one so flat areas keep their value
+		for (int k = 0; k < taps; k++) {
+			(*weights)[i * taps + k] /= sum;
+		}
+
+		(*first)[i] = start;
+	}
+
+	return taps;
+}
+
+// resizes srcImage into dstImage, box averages the covered block, bilinear uses the sampler
+// and Lanczos runs two separable passes of Lanczos-3 with weights computed on the host
+void resize_image(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, int srcWidth, int srcHeight,
+	const cl::Image2D* dstImage, int dstWidth, int dstHeight, ResizeFilter filter)
+{
+	cl::NDRange offset(0, 0);
+
+	if (filter == RESIZE_BOX || filter == RESIZE_BILINEAR) {
+		cl::Kernel kernel(*prog, filter == RESIZE_BOX ? "resize_box" : "resize_bilinear");
+
+		kernel.setArg(0, *srcImage);
+		kernel.setArg(1, *dstImage);
+
+		queue->enqueueNDRangeKernel(kernel, offset, cl::NDRange(dstWidth, dstHeight));
+		return;
+	}
+
+	std::vector<float> horzWeights, vertWeights;
+	std::vector<int> horzFirst, vertFirst;
+	int horzTaps = lanczos_weights(srcWidth, dstWidth, &horzWeights, &horzFirst);
+	int vertTaps = lanczos_weights(srcHeight, dstHeight, &vertWeights, &vertFirst);
+
+	cl::Buffer horzWeightBuffer(*ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_float) * horzWeights.size(), &horzWeights[0]);
+	cl::Buffer horzFirstBuffer(*ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_int) * horzFirst.size(), &horzFirst[0]);
+	cl::Buffer vertWeightBuffer(*ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_float) * vertWeights.size(), &vertWeights[0]);
+	cl::Buffer vertFirstBuffer(*ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_int) * vertFirst.size(), &vertFirst[0]);
+
+	// negative lobes can leave the 0-1 range, keep the intermediate as floats
+	cl::Image2D horzImage(*ctx, CL_MEM_READ_WRITE, intermediate_format(false), dstWidth, srcHeight);
+	cl::Kernel kernel(*prog, "resize_lanczos_pass");
+
+	// horizontal pass, changes the width only
+	kernel.setArg(0, *srcImage);
+	kernel.setArg(1, horzImage);
+	kernel.setArg(2, horzWeightBuffer);
+	kernel.setArg(3, horzFirstBuffer);
+	kernel.setArg(4, horzTaps);
+	kernel.setArg(5, 0);
+
+	queue->enqueueNDRangeKernel(kernel, offset, cl::NDRange(dstWidth, srcHeight));
+
+	// vertical pass, changes the height
+	kernel.setArg(0, horzImage);
+	kernel.setArg(1, *dstImage);
+	kernel.setArg(2, vertWeightBuffer);
+	kernel.setArg(3, vertFirstBuffer);
+	kernel.setArg(4, vertTaps);
+	kernel.setArg(5, 1);
+
+	queue->enqueueNDRangeKernel(kernel, offset, cl::NDRange(dstWidth, dstHeight));
+}
+
+// fills the pyramid with numLevels halvings of the source image
+void build_pyramid(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, int width, int height, int numLevels, ResizeFilter filter, ImagePyramid* pyramid)
+{
+	// only allocate level images when the size of the pyramid changes
+	bool reuse = (int)pyramid->levels.size() == numLevels + 1 && pyramid->widths[0] == width && pyramid->heights[0] == height;
+
+	if (!reuse) {
+		cl::ImageFormat format(CL_RGBA, CL_UNORM_INT8);
+
+		pyramid->levels.resize(numLevels + 1);
+		pyramid->widths.resize(numLevels + 1);
+		pyramid->heights.resize(numLevels + 1);
+
+		pyramid->widths[0] = width;
+		pyramid->heights[0] = height;
+
+		for (int i = 1; i <= numLevels; i++) {
+			pyramid->widths[i] = pyramid->widths[i - 1] / 2 > 1 ? pyramid->widths[i - 1] / 2 : 1;
+			pyramid->heights[i] = pyramid->heights[i - 1] / 2 > 1 ? pyramid->heights[i - 1] / 2 : 1;
+			pyramid->levels[i] = cl::Image2D(*ctx, CL_MEM_READ_WRITE, format, pyramid->widths[i], pyramid->heights[i]);
+		}
+	}
+
+	pyramid->levels[0] = *srcImage;
+
+	// each level is resized from the one above it
+	for (int i = 1; i <= numLevels; i++) {
+		resize_image(ctx, queue, prog, &pyramid->levels[i - 1], pyramid->widths[i - 1], pyramid->heights[i - 1],
+			&pyramid->levels[i], pyramid->widths[i], pyramid->heights[i], filter);
+	}
+}
+
+// median of each colour channel over a square window of the given radius (at most 8),
+// uses sliding column histograms so the cost per pixel does not grow with the radius
+void median_filter(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int radius)
+{
+	const int numBins = 256;		// must match MEDIAN_BINS in the kernel
+	const int stripWidth = 32;		// must match MEDIAN_STRIP in the kernel
+	const int stripHeight = 64;		// must match MEDIAN_ROWS in the kernel
+	const int maxRadius = 8;		// must match MAX_MEDIAN_RADIUS in the kernel
+
+	if (radius > maxRadius)
+		radius = maxRadius;
+
+	// channels are filtered one at a time into packed RGBA, alpha stays opaque
+	cl::Buffer pixelBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_uchar) * width * height * 4);
+	queue->enqueueFillBuffer(pixelBuffer, (cl_uchar)255, 0, sizeof(cl_uchar) * width * height * 4);
+
+	cl::Kernel kernel(*prog, "median_filter");
+	cl::NDRange globalSize((width + stripWidth - 1) / stripWidth * numBins, (height + stripHeight - 1) / stripHeight);
+
+	kernel.setArg(0, *srcImage);
+	kernel.setArg(1, pixelBuffer);
+	kernel.setArg(2, radius);
+
+	for (int channel = 0; channel < 3; channel++) {
+		kernel.setArg(3, channel);
+
+		queue->enqueueNDRangeKernel(kernel, cl::NDRange(0, 0), globalSize, cl::NDRange(numBins, 1));
+	}
+
+	cl::size_t<3> origin, region;
+	origin[0] = origin[1] = origin[2] = 0;
+	region[0] = width;
+	region[1] = height;
+	region[2] = 1;
+
+	queue->enqueueCopyBufferToImage(pixelBuffer, *dstImage, 0, origin, region);
+}
+
+// contrast limited adaptive histogram equalisation of the luminance, one mapping per tile
+// blended bilinearly between tiles, clipLimit is a multiple of the mean bin count
+void clahe(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height,
+	int tilesX, int tilesY, float clipLimit, Region roi)
+{
+	const int numBins = 256;		// must match CLAHE_BINS in the kernel
+
+	// 256-entry lookup table per tile, never leaves the device
+	cl::Buffer mappingBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_uchar) * numBins * tilesX * tilesY);
+
+	cl::Kernel mappingKernel(*prog, "clahe_tile_mapping");
+	cl::Kernel applyKernel(*prog, "clahe_apply");
+
+	// one work-group per tile
+	mappingKernel.setArg(0, *srcImage);
+	mappingKernel.setArg(1, tilesX);
+	mappingKernel.setArg(2, tilesY);
+	mappingKernel.setArg(3, clipLimit);
+	mappingKernel.setArg(4, mappingBuffer);
+
+	queue->enqueueNDRangeKernel(mappingKernel, cl::NDRange(0), cl::NDRange(numBins * tilesX * tilesY), cl::NDRange(numBins));
+
+	// remap every pixel, in-order queue so the tables are complete
+	applyKernel.setArg(0, *srcImage);
+	applyKernel.setArg(1, mappingBuffer);
+	applyKernel.setArg(2, tilesX);
+	applyKernel.setArg(3, tilesY);
+	applyKernel.setArg(4, *dstImage);
+
+	enqueue_region(queue, &applyKernel, roi);
+}
+
+// composites layers[1..numLayers-1] over layers[0] into dstImage, blends[i - 1] describes layers[i],
+// up to 3 layers are blended per launch with every layer read once
+void composite_layers(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* const* layers, const LayerBlend* blends, int numLayers,
+	const cl::Image2D* dstImage, int width, int height, Region roi)
+{
+	const int maxLayers = 4;		// must match MAX_COMPOSITE_LAYERS in the kernel
+
+	cl::Kernel kernel(*prog, "composite_layers");
+	cl::ImageFormat format(CL_RGBA, CL_UNORM_INT8);
+	cl::Image2D partial[2];			// results between launches when there are many layers
+
+	// blend table for every layer in constant memory
+	int numBlends = numLayers > 1 ? numLayers - 1 : 1;
+	cl::Buffer blendBuffer(*ctx, CL_MEM_READ_ONLY, sizeof(LayerBlend) * numBlends);
+	if (numLayers > 1)
+		queue->enqueueWriteBuffer(blendBuffer, CL_FALSE, 0, sizeof(LayerBlend) * (numLayers - 1), blends);
+
+	const cl::Image2D* backdrop = layers[0];
+	int next = 1;
+	int launch = 0;
+
+	kernel.setArg(4, blendBuffer);
+
+	do {
+		int count = numLayers - next < maxLayers - 1 ? numLayers - next : maxLayers - 1;
+		const cl::Image2D* target = dstImage;
+
+		// intermediate results alternate between two images, created when first needed
+		if (next + count < numLayers) {
+			if (launch < 2)
+				partial[launch] = cl::Image2D(*ctx, CL_MEM_READ_WRITE, format, width, height);
+			target = &partial[launch % 2];
+		}
+
+		// unused layer arguments are bound to the backdrop and never read
+		kernel.setArg(0, *backdrop);
+		for (int i = 1; i < maxLayers; i++) {
+			kernel.setArg(i, i <= count ? *layers[next + i - 1] : *backdrop);
+		}
+		kernel.setArg(5, next - 1);
+		kernel.setArg(6, count + 1);
+		kernel.setArg(7, *target);
+
+		// partial results outside the roi are never read
+		enqueue_region(queue, &kernel, roi);
+
+		// the result so far is the backdrop of the next launch
+		backdrop = target;
+		next += count;
+		launch++;
+	} while (next < numLayers);
+}
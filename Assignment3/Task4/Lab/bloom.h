@@ -0,0 +1,158 @@
+#pragma once
+#ifndef _BLOOM_H_
+#define _BLOOM_H_
+
+#include "common.h"
+
+// rectangle of pixels covered by a kernel launch
+struct Region {
+	int x, y;			// top-left pixel
+	int width, height;
+};
+
+// statistics of one bright blob, matches ComponentStats in the kernel
+struct ComponentStats {
+	cl_uint area;			// number of pixels
+	cl_int minX, minY;		// bounding box, inclusive
+	cl_int maxX, maxY;
+	cl_uint lumSum;			// luminance summed in 8-bit steps, mean is lumSum / (255 * area)
+};
+
+// blend modes of composited layers, match the BLEND_ defines in the kernel
+enum BlendMode { BLEND_NORMAL, BLEND_ADD, BLEND_MULTIPLY, BLEND_SCREEN, BLEND_LIGHTEN };
+
+// blend mode and opacity of one layer, matches LayerBlend in the kernel
+struct LayerBlend {
+	cl_int mode;
+	cl_float opacity;
+};
+
+// images kept between frames so that unchanged parts of the bloom can be reused
+struct BloomCache {
+	cl::Image2D glow;		// thresholded luminance
+	cl::Image2D blurHorz;	// after the horizontal blur pass
+	cl::Image2D blur;		// after both blur passes
+	cl::Image2D output;		// bloomed frame
+	cl::Buffer threshold;	// luminance threshold used by every update
+	int width, height;
+};
+
+// returns the image format for intermediate results, half floats halve the memory traffic
+cl::ImageFormat intermediate_format(bool halfFloat);
+
+// blurs the source image by downsampling it through a chain of half-resolution images,
+// then upsampling and accumulating back up the chain into the roi of the destination image,
+// the first skipLevels levels are left out of the average
+void mip_chain_blur(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int levels, int skipLevels,
+	bool halfFloat, Region roi);
+
+// computes the Young-van Vliet recursive Gaussian coefficients for sigma,
+// returned as (B, b1/b0, b2/b0, b3/b0)
+cl_float4 recursive_gaussian_coefficients(float sigma);
+
+// blurs the source image with a recursive Gaussian, one row then one column per work-item,
+// cost per pixel does not depend on sigma, full frame only as every output depends on the whole line
+void recursive_gaussian_blur(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, float sigma, bool halfFloat);
+
+// builds a summed-area table of the source image into satBuffer (width * height float4s),
+// luminance tables hold the luminance and its square instead of RGBA,
+// full frame only as every entry sums all pixels above and to the left of it
+void build_summed_area_table(const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Buffer* satBuffer, int width, int height, bool luminance);
+
+// box blurs the source image over a window of the given radius at constant cost per pixel,
+// only pixels inside the roi are written
+void box_blur(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int radius, Region roi);
+
+// keeps the luminance of pixels above both the threshold and mean + k * deviation of their neighbourhood,
+// only pixels inside the roi are written
+void adaptive_glowing_pixels(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height,
+	float threshold, int radius, float k, Region roi);
+
+// computes an Otsu threshold from a luminance histogram of the source image into thresholdBuffer
+void otsu_threshold(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Buffer* thresholdBuffer, int width, int height);
+
+// keeps the luminance of pixels above an Otsu threshold computed from a luminance histogram
+// of the whole image, the threshold never leaves the device and only pixels inside the roi are written
+void otsu_glowing_pixels(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, Region roi);
+
+// region covering the whole image
+Region full_region(int width, int height);
+
+// grows the region by haloX and haloY pixels on each side, clipped to the image
+Region expand_region(Region region, int haloX, int haloY, int width, int height);
+
+// enqueues a 2D kernel over the pixels of the region using a global offset
+void enqueue_region(const cl::CommandQueue* queue, const cl::Kernel* kernel, Region region);
+
+// creates the cached images and threshold buffer for the separable bloom pipeline
+void create_bloom_cache(const cl::Context* ctx, BloomCache* cache, int width, int height);
+
+// reruns glowing pixels, both blur passes and bloom only over the pixels affected by
+// the dirty region of the source image, other pixels keep their cached results
+void update_bloom_region(const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, BloomCache* cache, Region dirty);
+
+// morphological operations on the glowing pixel mask
+enum MorphOperation { MORPH_ERODE, MORPH_DILATE, MORPH_OPEN, MORPH_CLOSE };
+
+// applies a square structuring element of the given radius (at most 32) with separable
+// van Herk/Gil-Werman passes, cost per pixel does not depend on the radius,
+// srcImage and dstImage may be the same image, full frame only as the passes run over
+// fixed tiles of whole rows and columns and opening and closing run in place
+void morphology(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int radius, MorphOperation operation);
+
+// labels the 8-connected bright regions of the mask with union-find on the device and
+// reduces their statistics into stats, returns the number of components found,
+// only the first maxComponents are measured, full frame only as a component can extend past any region
+int label_components(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* maskImage, int width, int height, ComponentStats* stats, int maxComponents);
+
+// filters used when resizing images
+enum ResizeFilter { RESIZE_BOX, RESIZE_BILINEAR, RESIZE_LANCZOS };
+
+// half-resolution levels of an image, the images are reused when the pyramid is rebuilt
+// at the same size
+struct ImagePyramid {
+	std::vector<cl::Image2D> levels;	// level 0 is the source image
+	std::vector<int> widths, heights;
+};
+
+// resizes srcImage into dstImage, box averages the covered block, bilinear uses the sampler
+// and Lanczos runs two separable passes of Lanczos-3 with weights computed on the host,
+// full frame only as the host weight tables cover whole destination rows and columns
+void resize_image(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, int srcWidth, int srcHeight,
+	const cl::Image2D* dstImage, int dstWidth, int dstHeight, ResizeFilter filter);
+
+// fills the pyramid with numLevels halvings of the source image
+void build_pyramid(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, int width, int height, int numLevels, ResizeFilter filter, ImagePyramid* pyramid);
+
+// median of each colour channel over a square window of the given radius (at most 8),
+// uses sliding column histograms so the cost per pixel does not grow with the radius,
+// full frame only as each work-group slides its histograms down a fixed strip of the image
+void median_filter(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height, int radius);
+
+// contrast limited adaptive histogram equalisation of the luminance, one mapping per tile
+// blended bilinearly between tiles, clipLimit is a multiple of the mean bin count,
+// the tables cover the whole image and only pixels inside the roi are remapped
+void clahe(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* srcImage, const cl::Image2D* dstImage, int width, int height,
+	int tilesX, int tilesY, float clipLimit, Region roi);
+
+// composites layers[1..numLayers-1] over layers[0] into dstImage, blends[i - 1] describes layers[i],
+// up to 3 layers are blended per launch with every layer read once, only pixels inside the roi are written
+void composite_layers(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* const* layers, const LayerBlend* blends, int numLayers,
+	const cl::Image2D* dstImage, int width, int height, Region roi);
+
+#endif
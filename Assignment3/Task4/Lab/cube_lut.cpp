@@ -0,0 +1,166 @@
+#include "cube_lut.h"
+
+// converts a LUT value to a 16-bit normalised channel, values outside 0 to 1 are clamped
+static cl_ushort to_unorm16(float value)
+{
+	if (value < 0.0f)
+		value = 0.0f;
+	if (value > 1.0f)
+		value = 1.0f;
+
+	return (cl_ushort)(value * 65535.0f + 0.5f);
+}
+
+// reads a 3D LUT from a .cube file, returns false if the file cannot be read or is malformed
+bool load_cube_lut(const char* filename, CubeLut* lut)
+{
+	std::ifstream cubeFile(filename);
+
+	// check whether file opened successfully
+	if (!cubeFile.is_open())
+	{
+		std::cout << "Failed to open LUT file - " << filename << std::endl;
+		return false;
+	}
+
+	std::string line;
+	int numEntries = 0;
+	int expected = 0;
+
+	lut->size = 0;
+	lut->data.clear();
+	for (int c = 0; c < 3; c++) {
+		lut->domainMin[c] = 0.0f;
+		lut->domainMax[c] = 1.0f;
+	}
+
+	while (std::getline(cubeFile, line))
+	{
+		std::istringstream fields(line);
+		std::string keyword;
+
+		// skip blank lines and comments
+		if (!(fields >> keyword) || keyword[0] == '#')
+			continue;
+
+		if (keyword == "LUT_3D_SIZE")
+		{
+			fields >> lut->size;
+			if (lut->size < 2)
+			{
+				std::cout << "Invalid LUT size in " << filename << std::endl;
+				return false;
+			}
+
+			expected = lut->size * lut->size * lut->size;
+			lut->data.resize(expected * 4);
+		}
+		else if (keyword == "DOMAIN_MIN")
+		{
+			fields >> lut->domainMin[0] >> lut->domainMin[1] >> lut->domainMin[2];
+		}
+		else if (keyword == "DOMAIN_MAX")
+		{
+			fields >> lut->domainMax[0] >> lut->domainMax[1] >> lut->domainMax[2];
+		}
+		else if (keyword == "LUT_1D_SIZE")
+		{
+			std::cout << "1D LUTs are not supported - " << filename << std::endl;
+			return false;
+		}
+		else if (keyword == "LUT_3D_INPUT_RANGE")
+		{
+			// one range shared by all three channels
+			float rangeMin, rangeMax;
+			fields >> rangeMin >> rangeMax;
+
+			for (int c = 0; c < 3; c++) {
+				lut->domainMin[c] = rangeMin;
+				lut->domainMax[c] = rangeMax;
+			}
+		}
+		else if (keyword == "TITLE")
+		{
+			// nothing needed from this keyword
+		}
+		else
+		{
+			// data line, red green blue
+			float rgb[3];
+			std::istringstream values(line);
+
+			if (!(values >> rgb[0] >> rgb[1] >> rgb[2]) || numEntries >= expected)
+			{
+				std::cout << "Unexpected line in " << filename << ": " << line << std::endl;
+				return false;
+			}
+
+			for (int c = 0; c < 3; c++) {
+				lut->data[numEntries * 4 + c] = to_unorm16(rgb[c]);
+			}
+			lut->data[numEntries * 4 + 3] = 65535;
+			numEntries++;
+		}
+	}
+
+	if (lut->size == 0 || numEntries != expected)
+	{
+		std::cout << "Incomplete LUT in " << filename << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// fills the LUT with the identity mapping
+void identity_cube_lut(int size, CubeLut* lut)
+{
+	lut->size = size;
+	lut->data.resize(size * size * size * 4);
+
+	for (int c = 0; c < 3; c++) {
+		lut->domainMin[c] = 0.0f;
+		lut->domainMax[c] = 1.0f;
+	}
+
+	// red changes fastest, then green, then blue
+	for (int b = 0; b < size; b++) {
+		for (int g = 0; g < size; g++) {
+			for (int r = 0; r < size; r++) {
+				cl_ushort* entry = &lut->data[((b * size + g) * size + r) * 4];
+				entry[0] = to_unorm16((float)r / (size - 1));
+				entry[1] = to_unorm16((float)g / (size - 1));
+				entry[2] = to_unorm16((float)b / (size - 1));
+				entry[3] = 65535;
+			}
+		}
+	}
+}
+
+// creates a 3D image from the LUT for trilinear sampling on the device
+cl::Image3D create_lut_image(const cl::Context* ctx, const CubeLut* lut)
+{
+	// normalised 16-bit channels can always be filtered by the sampler, unlike floats
+	cl::ImageFormat format(CL_RGBA, CL_UNORM_INT16);
+
+	return cl::Image3D(*ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, format, lut->size, lut->size, lut->size, 0, 0, (void*)&lut->data[0]);
+}
+
+// sets the LUT image, domain and size as four consecutive kernel arguments starting at firstArg
+void set_lut_args(cl::Kernel* kernel, int firstArg, const cl::Image3D* lutImage, const CubeLut* lut)
+{
+	cl_float4 domainMin, domainScale;
+
+	// input colours are mapped to 0 to 1 across the domain
+	for (int c = 0; c < 3; c++) {
+		domainMin.s[c] = lut->domainMin[c];
+		domainScale.s[c] = 1.0f / (lut->domainMax[c] - lut->domainMin[c]);
+	}
+	domainMin.s[3] = 0.0f;
+	domainScale.s[3] = 1.0f;
+
+	kernel->setArg(firstArg, *lutImage);
+	kernel->setArg(firstArg + 1, domainMin);
+	kernel->setArg(firstArg + 2, domainScale);
+	kernel->setArg(firstArg + 3, (cl_float)lut->size);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef _CUBE_LUT_H_
+#define _CUBE_LUT_H_
+
+#include "common.h"
+
+// 3D colour lookup table, entries are RGBA with red changing fastest, then green, then blue
+struct CubeLut {
+	int size;						// entries along each axis, e.g. 17, 33 or 65
+	float domainMin[3];				// input colour mapped to the first entry
+	float domainMax[3];				// input colour mapped to the last entry
+	std::vector<cl_ushort> data;	// size^3 RGBA entries as 16-bit normalised values
+};
+
+// reads a 3D LUT from a .cube file, returns false if the file cannot be read or is malformed
+bool load_cube_lut(const char* filename, CubeLut* lut);
+
+// fills the LUT with the identity mapping
+void identity_cube_lut(int size, CubeLut* lut);
+
+// creates a 3D image from the LUT for trilinear sampling on the device
+cl::Image3D create_lut_image(const cl::Context* ctx, const CubeLut* lut);
+
+// sets the LUT image, domain and size as four consecutive kernel arguments starting at firstArg
+void set_lut_args(cl::Kernel* kernel, int firstArg, const cl::Image3D* lutImage, const CubeLut* lut);
+
+#endif
@@ -0,0 +1,72 @@
+#include <cmath>
+
+#include "metrics.h"
+
+// reduces a per-pixel metric of two images to its sum over the image on the device,
+// only the final float is read back
+static float reduce_image_pair(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const char* kernelName, const cl::Image2D* imageA, const cl::Image2D* imageB, int width, int height)
+{
+	const int groupSize = 16;		// work-group width and height, must be a power of two
+	const int reduceSize = 256;		// work-items summing the partial sums
+
+	int groupsX = (width + groupSize - 1) / groupSize;
+	int groupsY = (height + groupSize - 1) / groupSize;
+	float sum;
+
+	cl::Buffer partialBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_float) * groupsX * groupsY);
+	cl::Buffer resultBuffer(*ctx, CL_MEM_READ_WRITE, sizeof(cl_float));
+
+	cl::Kernel pixelKernel(*prog, kernelName);
+	cl::Kernel sumKernel(*prog, "sum_partials");
+
+	// one partial sum per work-group
+	pixelKernel.setArg(0, *imageA);
+	pixelKernel.setArg(1, *imageB);
+	pixelKernel.setArg(2, cl::Local(sizeof(cl_float) * groupSize * groupSize));
+	pixelKernel.setArg(3, partialBuffer);
+
+	queue->enqueueNDRangeKernel(pixelKernel, cl::NDRange(0, 0), cl::NDRange(groupsX * groupSize, groupsY * groupSize),
+		cl::NDRange(groupSize, groupSize));
+
+	// a single work-group adds the partial sums
+	sumKernel.setArg(0, partialBuffer);
+	sumKernel.setArg(1, groupsX * groupsY);
+	sumKernel.setArg(2, cl::Local(sizeof(cl_float) * reduceSize));
+	sumKernel.setArg(3, resultBuffer);
+
+	queue->enqueueNDRangeKernel(sumKernel, cl::NDRange(0), cl::NDRange(reduceSize), cl::NDRange(reduceSize));
+
+	queue->enqueueReadBuffer(resultBuffer, CL_TRUE, 0, sizeof(cl_float), &sum);
+
+	return sum;
+}
+
+// peak signal-to-noise ratio in dB between two images of the same size, over RGB,
+// infinite for identical images
+float compute_psnr(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* imageA, const cl::Image2D* imageB, int width, int height)
+{
+	float squaredError = reduce_image_pair(ctx, queue, prog, "squared_error_sum", imageA, imageB, width, height);
+	float mse = squaredError / (3.0f * width * height);
+
+	if (mse <= 0.0f)
+		return HUGE_VALF;
+
+	// pixel values range from 0 to 1, so the peak is 1
+	return -10.0f * log10f(mse);
+}
+
+// mean structural similarity of the luminance of two images over an 11x11 Gaussian window,
+// 1 for identical images
+float compute_ssim(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* imageA, const cl::Image2D* imageB, int width, int height)
+{
+	return reduce_image_pair(ctx, queue, prog, "ssim_sum", imageA, imageB, width, height) / ((float)width * height);
+}
+
+// true when both metrics reach their floors, used to accept approximate fast paths
+bool meets_quality_floor(float psnr, float ssim, float minPsnr, float minSsim)
+{
+	return psnr >= minPsnr && ssim >= minSsim;
+}
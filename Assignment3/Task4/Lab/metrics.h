@@ -0,0 +1,20 @@
+#pragma once
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include "common.h"
+
+// peak signal-to-noise ratio in dB between two images of the same size, over RGB,
+// infinite for identical images
+float compute_psnr(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* imageA, const cl::Image2D* imageB, int width, int height);
+
+// mean structural similarity of the luminance of two images over an 11x11 Gaussian window,
+// 1 for identical images
+float compute_ssim(const cl::Context* ctx, const cl::CommandQueue* queue, const cl::Program* prog,
+	const cl::Image2D* imageA, const cl::Image2D* imageB, int width, int height);
+
+// true when both metrics reach their floors, used to accept approximate fast paths
+bool meets_quality_floor(float psnr, float ssim, float minPsnr, float minSsim);
+
+#endif
@@ -1,18 +1,31 @@
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | 
       CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST; 
 
+__constant sampler_t linear_sampler = CLK_NORMALIZED_COORDS_FALSE | 
+      CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR; 
+
+// trilinear sampling of 3D colour lookup tables
+__constant sampler_t lut_sampler = CLK_NORMALIZED_COORDS_TRUE | 
+      CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR; 
+
 __constant float Weights[7] = {
 	0.00598, 0.060626, 0.241843, 0.383103, 0.241843, 0.060626, 0.00598
 };
 
-__kernel void glowing_pixels(
+// 3x3 tent filter used when upsampling the mip chain
+__constant float TentFilter[9] = {	1.0/16, 2.0/16, 1.0/16,
+									2.0/16, 4.0/16, 2.0/16,
+									1.0/16, 2.0/16, 1.0/16};
+
+#define HISTOGRAM_BINS 256
+
+// keeps the luminance of the pixel at coord if it reaches the threshold
+void threshold_pixel(
 	read_only image2d_t src_image,
 	float threshold,
-	write_only image2d_t dst_image
+	write_only image2d_t dst_image,
+	int2 coord
 ) {
-	// get pixel coordinate
-	int2 coord = (int2) (get_global_id(0), get_global_id(1));
-
 	// read pixel value
 	float4 pixel = read_imagef(src_image, sampler, coord);
 
@@ -33,6 +46,113 @@ __kernel void glowing_pixels(
 	write_imagef(dst_image, coord, pixel);
 }
 
+__kernel void glowing_pixels(
+	read_only image2d_t src_image,
+	float threshold,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	threshold_pixel(src_image, threshold, dst_image, coord);
+}
+
+__kernel void glowing_pixels_auto(
+	read_only image2d_t src_image,
+	__global const float* threshold,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// threshold computed on the device by an earlier kernel
+	threshold_pixel(src_image, threshold[0], dst_image, coord);
+}
+
+__kernel void luminance_histogram(
+	read_only image2d_t src_image,
+	__global uint* histogram
+) {
+	// work-group's private copy of the bins
+	__local uint local_bins[HISTOGRAM_BINS];
+
+	int lid = get_local_id(1) * get_local_size(0) + get_local_id(0);
+	int group_size = get_local_size(0) * get_local_size(1);
+
+	// clear the local bins
+	for (int i = lid; i < HISTOGRAM_BINS; i += group_size) {
+		local_bins[i] = 0;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// get pixel coordinate, the global size is rounded up to the work-group size
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	int2 dim = get_image_dim(src_image);
+
+	if (coord.x < dim.x && coord.y < dim.y) {
+		// read pixel value
+		float4 pixel = read_imagef(src_image, sampler, coord);
+
+		// calculate luminance and its bin
+		float lum = 0.299 * pixel.x + 0.587 * pixel.y + 0.114 * pixel.z;
+		int bin = clamp((int)(lum * HISTOGRAM_BINS), 0, HISTOGRAM_BINS - 1);
+
+		atomic_inc(&local_bins[bin]);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// merge the local bins into the global histogram
+	for (int i = lid; i < HISTOGRAM_BINS; i += group_size) {
+		if (local_bins[i] > 0) {
+			atomic_add(&histogram[i], local_bins[i]);
+		}
+	}
+}
+
+__kernel void otsu_threshold(
+	__global const uint* histogram,
+	__global float* threshold
+) {
+	// total pixel count and luminance sum
+	float total = 0.0f;
+	float sum = 0.0f;
+
+	for (int i = 0; i < HISTOGRAM_BINS; i++) {
+		total += histogram[i];
+		sum += i * (float)histogram[i];
+	}
+
+	// background weight and luminance sum
+	float weight_bg = 0.0f;
+	float sum_bg = 0.0f;
+
+	float max_variance = 0.0f;
+	int best = HISTOGRAM_BINS - 1;
+
+	// find the split maximising the between-class variance
+	for (int t = 0; t < HISTOGRAM_BINS - 1; t++) {
+		weight_bg += histogram[t];
+		sum_bg += t * (float)histogram[t];
+
+		float weight_fg = total - weight_bg;
+		if (weight_bg == 0.0f || weight_fg == 0.0f) {
+			continue;
+		}
+
+		float mean_bg = sum_bg / weight_bg;
+		float mean_fg = (sum - sum_bg) / weight_fg;
+		float variance = weight_bg * weight_fg * (mean_bg - mean_fg) * (mean_bg - mean_fg);
+
+		if (variance > max_variance) {
+			max_variance = variance;
+			best = t;
+		}
+	}
+
+	// pixels in bins above the split are foreground
+	threshold[0] = (float)(best + 1) / HISTOGRAM_BINS;
+}
+
 __kernel void blur_pass(read_only image2d_t src_image,
 						write_only image2d_t dst_image,
 						int pass_type) {
@@ -83,6 +203,79 @@ __kernel void blur_pass(read_only image2d_t src_image,
 	write_imagef(dst_image, coord, sum);
 }
 
+__kernel void iir_blur_pass(read_only image2d_t src_image,
+						write_only image2d_t dst_image,
+						int pass_type,
+						float4 coefficients,
+						__global float* scratch,
+						int half_scratch) {
+
+	// get the row (horizontal pass) or column (vertical pass) filtered by this work-item
+	int line = get_global_id(0);
+	int num_lines = get_global_size(0);
+
+	// get image dimensions
+	int2 dim = get_image_dim(src_image);
+
+	int length;
+	int2 start, step;
+
+	// Horizontal pass
+	if (pass_type == 0) {
+		length = dim.x;
+		start = (int2)(0, line);
+		step = (int2)(1, 0);
+	}
+	// Vertical pass
+	else {
+		length = dim.y;
+		start = (int2)(line, 0);
+		step = (int2)(0, 1);
+	}
+
+	// filter coefficients (B, b1/b0, b2/b0, b3/b0)
+	float B = coefficients.x;
+
+	// causal filter, history initialised to the edge pixel
+	float4 pixel = read_imagef(src_image, sampler, start);
+	float4 w1 = pixel, w2 = pixel, w3 = pixel;
+
+	for (int i = 0; i < length; i++) {
+		pixel = read_imagef(src_image, sampler, start + step * i);
+
+		float4 w0 = B * pixel + coefficients.y * w1 + coefficients.z * w2 + coefficients.w * w3;
+
+		// interleave lines so neighbouring work-items access neighbouring addresses
+		if (half_scratch) {
+			vstore_half4(w0, i * num_lines + line, (__global half*)scratch);
+		}
+		else {
+			vstore4(w0, i * num_lines + line, scratch);
+		}
+
+		w3 = w2;
+		w2 = w1;
+		w1 = w0;
+	}
+
+	// anticausal filter, history initialised to the last causal value
+	float4 y1 = w1, y2 = w1, y3 = w1;
+
+	for (int i = length - 1; i >= 0; i--) {
+		// stored as half or float, filtered in float
+		float4 w0 = half_scratch ? vload_half4(i * num_lines + line, (__global half*)scratch) : vload4(i * num_lines + line, scratch);
+
+		float4 y0 = B * w0 + coefficients.y * y1 + coefficients.z * y2 + coefficients.w * y3;
+
+		// write new pixel value to output
+		write_imagef(dst_image, start + step * i, y0);
+
+		y3 = y2;
+		y2 = y1;
+		y1 = y0;
+	}
+}
+
 __kernel void bloom(
 	read_only image2d_t src_image,
 	read_only image2d_t src_image_blur,
@@ -105,4 +298,959 @@ __kernel void bloom(
 
 	// write new pixel value to output
 	write_imagef(dst_image, coord, pixel);
-}
\ No newline at end of file
+}
+
+__kernel void mip_downsample(
+	read_only image2d_t src_image,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// centre of the destination pixel in source image coordinates
+	float2 scale = convert_float2(get_image_dim(src_image)) / convert_float2(get_image_dim(dst_image));
+	float2 pos = (convert_float2(coord) + 0.5f) * scale;
+
+	// centre tap plus four diagonal taps, each bilinear tap averages a 2x2 block
+	float4 sum = read_imagef(src_image, linear_sampler, pos) * 0.5f;
+	sum += read_imagef(src_image, linear_sampler, pos + (float2)(-1.0f, -1.0f)) * 0.125f;
+	sum += read_imagef(src_image, linear_sampler, pos + (float2)(1.0f, -1.0f)) * 0.125f;
+	sum += read_imagef(src_image, linear_sampler, pos + (float2)(-1.0f, 1.0f)) * 0.125f;
+	sum += read_imagef(src_image, linear_sampler, pos + (float2)(1.0f, 1.0f)) * 0.125f;
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, sum);
+}
+
+__kernel void mip_upsample(
+	read_only image2d_t src_image_low,
+	read_only image2d_t src_image,
+	write_only image2d_t dst_image,
+	float level_weight,
+	float scale
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// centre of the destination pixel in lower level coordinates
+	float2 ratio = convert_float2(get_image_dim(src_image_low)) / convert_float2(get_image_dim(dst_image));
+	float2 pos = (convert_float2(coord) + 0.5f) * ratio;
+
+	// accumulated pixel value
+	float4 sum = (float4)(0.0);
+
+	// filter's current index
+	int filter_index = 0;
+
+	// apply tent filter over the lower level
+	for (int i = -1; i <= 1; i++) {
+		for (int j = -1; j <= 1; j++) {
+			sum += read_imagef(src_image_low, linear_sampler, pos + (float2)(j, i)) * TentFilter[filter_index++];
+		}
+	}
+
+	// add this level's own pixel value, skipped levels have a zero weight
+	float4 pixel = read_imagef(src_image, sampler, coord);
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, (pixel * level_weight + sum) * scale);
+}
+
+// sums a summed-area table over the window of the given radius around coord,
+// the window is clamped to the image and its pixel count returned in area
+float4 sat_window_sum(__global const float4* sat, int2 dim, int2 coord, int radius, float* area) {
+
+	// window corners, x0 and y0 sit one pixel before the window
+	int x0 = max(coord.x - radius, 0) - 1;
+	int y0 = max(coord.y - radius, 0) - 1;
+	int x1 = min(coord.x + radius, dim.x - 1);
+	int y1 = min(coord.y + radius, dim.y - 1);
+
+	float4 sum = sat[y1 * dim.x + x1];
+
+	if (x0 >= 0) {
+		sum -= sat[y1 * dim.x + x0];
+	}
+	if (y0 >= 0) {
+		sum -= sat[y0 * dim.x + x1];
+	}
+	if (x0 >= 0 && y0 >= 0) {
+		sum += sat[y0 * dim.x + x0];
+	}
+
+	*area = (float)((x1 - x0) * (y1 - y0));
+
+	return sum;
+}
+
+__kernel void sat_row_scan(
+	read_only image2d_t src_image,
+	__global float4* sat,
+	int luminance
+) {
+	// get work-item's row position
+	int row = get_global_id(0);
+
+	// get image dimensions
+	int2 dim = get_image_dim(src_image);
+
+	// running sum along the row
+	float4 sum = (float4)(0.0);
+	float4 pixel;
+
+	for (int column = 0; column < dim.x; column++) {
+		// read pixel value
+		pixel = read_imagef(src_image, sampler, (int2)(column, row));
+
+		// luminance tables hold the luminance and its square for variance
+		if (luminance) {
+			float lum = 0.299 * pixel.x + 0.587 * pixel.y + 0.114 * pixel.z;
+			pixel = (float4)(lum, lum * lum, 0.0, 0.0);
+		}
+
+		sum += pixel;
+		sat[row * dim.x + column] = sum;
+	}
+}
+
+__kernel void sat_column_scan(
+	__global float4* sat,
+	int width,
+	int height
+) {
+	// get work-item's column position
+	int column = get_global_id(0);
+
+	// running sum down the column, neighbouring work-items read neighbouring addresses
+	float4 sum = (float4)(0.0);
+
+	for (int row = 0; row < height; row++) {
+		sum += sat[row * width + column];
+		sat[row * width + column] = sum;
+	}
+}
+
+__kernel void box_blur(
+	__global const float4* sat,
+	int radius,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	float area;
+
+	// average of the window, four reads whatever the radius
+	float4 sum = sat_window_sum(sat, get_image_dim(dst_image), coord, radius, &area);
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, sum / area);
+}
+
+__kernel void adaptive_glowing_pixels(
+	read_only image2d_t src_image,
+	__global const float4* sat,
+	float threshold,
+	int radius,
+	float k,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	float area;
+
+	// read pixel value
+	float4 pixel = read_imagef(src_image, sampler, coord);
+
+	// calculate luminance
+	float lum = 0.299 * pixel.x + 0.587 * pixel.y + 0.114 * pixel.z;
+
+	// local luminance statistics from the summed-area table
+	float4 sum = sat_window_sum(sat, get_image_dim(src_image), coord, radius, &area);
+	float mean = sum.x / area;
+	float variance = max(sum.y / area - mean * mean, 0.0f);
+
+	// if below the global threshold or not bright enough for its neighbourhood, make it black
+	if (lum < max(threshold, mean + k * sqrt(variance))) {
+		lum = 0;
+	}
+
+	// replace RGB values with luminance
+	pixel.xyz = (float3)(lum, lum, lum);
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, pixel);
+}
+
+#define MORPH_TILE 64			// pixels produced by a work-group along the pass
+#define MAX_MORPH_RADIUS 32		// largest structuring element radius held in local memory
+
+// minimum for erosion, maximum for dilation
+float4 morph_op(float4 a, float4 b, int dilate) {
+	return dilate ? fmax(a, b) : fmin(a, b);
+}
+
+__kernel void morph_pass(
+	read_only image2d_t src_image,
+	write_only image2d_t dst_image,
+	int radius,
+	int pass_type,
+	int dilate
+) {
+	// segment of the line covered by the work-group, plus the window either side
+	__local float4 prefix[MORPH_TILE + 2 * MAX_MORPH_RADIUS];
+	__local float4 suffix[MORPH_TILE + 2 * MAX_MORPH_RADIUS];
+
+	// horizontal passes run along x, vertical passes along y
+	int dir = pass_type == 0 ? 0 : 1;
+	int lid = get_local_id(dir);
+	int start = get_group_id(dir) * MORPH_TILE - radius;
+
+	int2 dim = get_image_dim(src_image);
+	int2 coord = (int2)(get_global_id(0), get_global_id(1));
+
+	int window = 2 * radius + 1;
+	int length = MORPH_TILE + 2 * radius;
+
+	// load the segment, edge pixels are repeated outside the image
+	for (int i = lid; i < length; i += MORPH_TILE) {
+		int2 pos = coord;
+		if (dir == 0)
+			pos.x = start + i;
+		else
+			pos.y = start + i;
+
+		float4 pixel = read_imagef(src_image, sampler, pos);
+		prefix[i] = pixel;
+		suffix[i] = pixel;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// van Herk/Gil-Werman: running min/max from the start and from the end of each
+	// block of window pixels, one block per work-item
+	int num_blocks = (length + window - 1) / window;
+
+	for (int block = lid; block < num_blocks; block += MORPH_TILE) {
+		int first = block * window;
+		int last = min(first + window, length) - 1;
+
+		for (int i = first + 1; i <= last; i++) {
+			prefix[i] = morph_op(prefix[i - 1], prefix[i], dilate);
+		}
+		for (int i = last - 1; i >= first; i--) {
+			suffix[i] = morph_op(suffix[i + 1], suffix[i], dilate);
+		}
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// any window spans at most two blocks, so two values give the result
+	if (coord.x < dim.x && coord.y < dim.y) {
+		float4 pixel = morph_op(suffix[lid], prefix[lid + window - 1], dilate);
+
+		// write new pixel value to output
+		write_imagef(dst_image, coord, pixel);
+	}
+}
+
+// statistics of one connected component, matches ComponentStats on the host
+typedef struct {
+	uint area;
+	int min_x, min_y;
+	int max_x, max_y;
+	uint lum_sum;		// luminance summed in 8-bit steps
+} ComponentStats;
+
+// follows parent links until reaching a label that is its own parent
+int find_root(volatile __global int* labels, int label) {
+	int parent = labels[label];
+
+	while (parent != label) {
+		label = parent;
+		parent = labels[label];
+	}
+
+	return label;
+}
+
+// joins the trees holding a and b, the smaller root always becomes the parent
+void union_labels(volatile __global int* labels, int a, int b) {
+	int done = 0;
+
+	while (!done) {
+		a = find_root(labels, a);
+		b = find_root(labels, b);
+
+		if (a < b) {
+			// another work-item may have linked b first, then retry from its new parent
+			int old = atomic_min(&labels[b], a);
+			done = (old == b);
+			b = old;
+		}
+		else if (b < a) {
+			int old = atomic_min(&labels[a], b);
+			done = (old == a);
+			a = old;
+		}
+		else {
+			done = 1;
+		}
+	}
+}
+
+__kernel void ccl_init(
+	read_only image2d_t mask_image,
+	__global int* labels
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	int index = coord.y * get_image_dim(mask_image).x + coord.x;
+
+	// every bright pixel starts as its own component, -1 marks the background
+	float4 pixel = read_imagef(mask_image, sampler, coord);
+	labels[index] = pixel.x > 0.0f ? index : -1;
+}
+
+__kernel void ccl_merge(
+	volatile __global int* labels,
+	int width,
+	int height
+) {
+	// get pixel coordinate
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int index = y * width + x;
+
+	if (labels[index] < 0)
+		return;
+
+	// 8-connectivity, each pair is joined once by the later pixel in raster order
+	if (x > 0 && labels[index - 1] >= 0)
+		union_labels(labels, index, index - 1);
+
+	if (y > 0) {
+		if (x > 0 && labels[index - width - 1] >= 0)
+			union_labels(labels, index, index - width - 1);
+		if (labels[index - width] >= 0)
+			union_labels(labels, index, index - width);
+		if (x < width - 1 && labels[index - width + 1] >= 0)
+			union_labels(labels, index, index - width + 1);
+	}
+}
+
+__kernel void ccl_compress(
+	__global int* labels,
+	__global int* component_ids,
+	__global uint* num_components,
+	int width,
+	int height
+) {
+	// get pixel coordinate
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	if (x >= width || y >= height)
+		return;
+
+	int index = y * width + x;
+	int label = labels[index];
+
+	if (label < 0)
+		return;
+
+	// roots get consecutive component numbers
+	if (label == index)
+		component_ids[index] = atomic_inc(num_components);
+
+	// point every pixel straight at its root
+	labels[index] = find_root(labels, label);
+}
+
+__kernel void ccl_statistics(
+	read_only image2d_t mask_image,
+	__global const int* labels,
+	__global const int* component_ids,
+	__global ComponentStats* stats,
+	int width,
+	int height,
+	int max_components
+) {
+	// get pixel coordinate
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	if (x >= width || y >= height)
+		return;
+
+	int index = y * width + x;
+	int label = labels[index];
+
+	// only the first pixel of each run of equal labels along a row does any work
+	if (label < 0 || (x > 0 && labels[index - 1] == label))
+		return;
+
+	int id = component_ids[label];
+	if (id >= max_components)
+		return;
+
+	// reduce the whole run privately, then merge it with one set of atomics
+	uint lum_sum = 0;
+	int end = x;
+
+	while (end < width && labels[y * width + end] == label) {
+		float4 pixel = read_imagef(mask_image, sampler, (int2)(end, y));
+		lum_sum += (uint)(pixel.x * 255.0f + 0.5f);
+		end++;
+	}
+
+	atomic_add(&stats[id].area, (uint)(end - x));
+	atomic_add(&stats[id].lum_sum, lum_sum);
+	atomic_min(&stats[id].min_x, x);
+	atomic_max(&stats[id].max_x, end - 1);
+	atomic_min(&stats[id].min_y, y);
+	atomic_max(&stats[id].max_y, y);
+}
+
+__kernel void resize_box(
+	read_only image2d_t src_image,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// block of source pixels covered by the destination pixel, at least one pixel wide
+	int2 src_dim = get_image_dim(src_image);
+	float2 scale = convert_float2(src_dim) / convert_float2(get_image_dim(dst_image));
+	int2 first = convert_int2(floor(convert_float2(coord) * scale));
+	int2 last = max(convert_int2(ceil(convert_float2(coord + 1) * scale)), first + 1);
+	last = min(last, src_dim);
+
+	// average the block
+	float4 sum = (float4)(0.0);
+
+	for (int y = first.y; y < last.y; y++) {
+		for (int x = first.x; x < last.x; x++) {
+			sum += read_imagef(src_image, sampler, (int2)(x, y));
+		}
+	}
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, sum / (float)((last.x - first.x) * (last.y - first.y)));
+}
+
+__kernel void resize_bilinear(
+	read_only image2d_t src_image,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// centre of the destination pixel in source image coordinates
+	float2 scale = convert_float2(get_image_dim(src_image)) / convert_float2(get_image_dim(dst_image));
+	float2 pos = (convert_float2(coord) + 0.5f) * scale;
+
+	// the sampler interpolates between the four nearest pixels
+	write_imagef(dst_image, coord, read_imagef(src_image, linear_sampler, pos));
+}
+
+__kernel void resize_lanczos_pass(
+	read_only image2d_t src_image,
+	write_only image2d_t dst_image,
+	__global const float* weights,
+	__global const int* first,
+	int taps,
+	int pass_type
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// horizontal passes resample along x, vertical passes along y
+	int index = pass_type == 0 ? coord.x : coord.y;
+	int2 pos = coord;
+
+	// weighted sum of the precomputed taps, edge pixels repeat outside the image
+	float4 sum = (float4)(0.0);
+
+	for (int i = 0; i < taps; i++) {
+		if (pass_type == 0)
+			pos.x = first[index] + i;
+		else
+			pos.y = first[index] + i;
+
+		sum += read_imagef(src_image, sampler, pos) * weights[index * taps + i];
+	}
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, sum);
+}
+
+#define SSIM_RADIUS 5			// 11x11 window
+#define SSIM_SIGMA 1.5f			// standard deviation of the window weights
+
+// sums value over the work-group, scratch holds one float per work-item
+float group_sum(__local float* scratch, float value) {
+	int lid = get_local_id(1) * get_local_size(0) + get_local_id(0);
+	int size = get_local_size(0) * get_local_size(1);
+
+	scratch[lid] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// tree reduction, the group size is a power of two
+	for (int stride = size / 2; stride > 0; stride /= 2) {
+		if (lid < stride)
+			scratch[lid] += scratch[lid + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	return scratch[0];
+}
+
+// writes the group's total to its slot of partial_sums
+void store_group_sum(__local float* scratch, float value, __global float* partial_sums) {
+	float sum = group_sum(scratch, value);
+
+	if (get_local_id(0) == 0 && get_local_id(1) == 0)
+		partial_sums[get_group_id(1) * get_num_groups(0) + get_group_id(0)] = sum;
+}
+
+__kernel void squared_error_sum(
+	read_only image2d_t image_a,
+	read_only image2d_t image_b,
+	__local float* scratch,
+	__global float* partial_sums
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	int2 dim = get_image_dim(image_a);
+	float error = 0.0f;
+
+	// work-items past the edge still take part in the reduction
+	if (coord.x < dim.x && coord.y < dim.y) {
+		float4 diff = read_imagef(image_a, sampler, coord) - read_imagef(image_b, sampler, coord);
+		error = diff.x * diff.x + diff.y * diff.y + diff.z * diff.z;
+	}
+
+	store_group_sum(scratch, error, partial_sums);
+}
+
+__kernel void ssim_sum(
+	read_only image2d_t image_a,
+	read_only image2d_t image_b,
+	__local float* scratch,
+	__global float* partial_sums
+) {
+	// stabilising constants for a dynamic range of 1
+	const float c1 = 0.01f * 0.01f;
+	const float c2 = 0.03f * 0.03f;
+
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	int2 dim = get_image_dim(image_a);
+	float ssim = 0.0f;
+
+	if (coord.x < dim.x && coord.y < dim.y) {
+		// Gaussian weighted luminance statistics over the window
+		float weight_sum = 0.0f;
+		float mean_a = 0.0f, mean_b = 0.0f;
+		float sq_a = 0.0f, sq_b = 0.0f, prod = 0.0f;
+
+		for (int dy = -SSIM_RADIUS; dy <= SSIM_RADIUS; dy++) {
+			for (int dx = -SSIM_RADIUS; dx <= SSIM_RADIUS; dx++) {
+				float w = exp(-(float)(dx * dx + dy * dy) / (2.0f * SSIM_SIGMA * SSIM_SIGMA));
+				float4 pa = read_imagef(image_a, sampler, coord + (int2)(dx, dy));
+				float4 pb = read_imagef(image_b, sampler, coord + (int2)(dx, dy));
+				float la = 0.299f * pa.x + 0.587f * pa.y + 0.114f * pa.z;
+				float lb = 0.299f * pb.x + 0.587f * pb.y + 0.114f * pb.z;
+
+				weight_sum += w;
+				mean_a += w * la;
+				mean_b += w * lb;
+				sq_a += w * la * la;
+				sq_b += w * lb * lb;
+				prod += w * la * lb;
+			}
+		}
+
+		mean_a /= weight_sum;
+		mean_b /= weight_sum;
+		float var_a = sq_a / weight_sum - mean_a * mean_a;
+		float var_b = sq_b / weight_sum - mean_b * mean_b;
+		float cov = prod / weight_sum - mean_a * mean_b;
+
+		ssim = ((2.0f * mean_a * mean_b + c1) * (2.0f * cov + c2)) /
+			((mean_a * mean_a + mean_b * mean_b + c1) * (var_a + var_b + c2));
+	}
+
+	store_group_sum(scratch, ssim, partial_sums);
+}
+
+__kernel void sum_partials(
+	__global const float* partial_sums,
+	int count,
+	__local float* scratch,
+	__global float* result
+) {
+	// each work-item first adds a strided subset, then the group reduces them
+	float sum = 0.0f;
+
+	for (int i = get_local_id(0); i < count; i += get_local_size(0)) {
+		sum += partial_sums[i];
+	}
+
+	sum = group_sum(scratch, sum);
+
+	if (get_local_id(0) == 0)
+		result[0] = sum;
+}
+
+#define MEDIAN_BINS 256			// one work-item per 8-bit level
+#define MEDIAN_STRIP 32			// output columns per work-group
+#define MEDIAN_ROWS 64			// output rows per work-group
+#define MAX_MEDIAN_RADIUS 8
+
+// 8-bit level of one channel of a pixel
+int channel_level(read_only image2d_t src_image, int2 coord, int channel) {
+	float4 pixel = read_imagef(src_image, sampler, coord);
+	float value = channel == 0 ? pixel.x : (channel == 1 ? pixel.y : pixel.z);
+
+	return convert_int_sat_rte(value * 255.0f);
+}
+
+__kernel __attribute__((reqd_work_group_size(MEDIAN_BINS, 1, 1)))
+void median_filter(
+	read_only image2d_t src_image,
+	__global uchar* dst_buffer,
+	int radius,
+	int channel
+) {
+	// histogram of every column of the strip and its halo over the 2r+1 rows of the window
+	__local uchar columns[MEDIAN_BINS][MEDIAN_STRIP + 2 * MAX_MEDIAN_RADIUS];
+	// histogram of the full window of every output pixel on the current row
+	__local ushort windows[MEDIAN_STRIP][MEDIAN_BINS];
+
+	int lid = get_local_id(0);
+	int2 dim = get_image_dim(src_image);
+
+	// first output pixel of the work-group and the first column of its halo
+	int x0 = get_group_id(0) * MEDIAN_STRIP;
+	int y0 = get_group_id(1) * MEDIAN_ROWS;
+	int y1 = min(y0 + MEDIAN_ROWS, dim.y);
+	int halo_x = x0 - radius;
+
+	int num_columns = MEDIAN_STRIP + 2 * radius;
+	int window = 2 * radius + 1;
+	int rank = (window * window + 1) / 2;
+
+	// clear the column histograms
+	for (int i = lid; i < MEDIAN_BINS * (MEDIAN_STRIP + 2 * MAX_MEDIAN_RADIUS); i += MEDIAN_BINS) {
+		columns[i / (MEDIAN_STRIP + 2 * MAX_MEDIAN_RADIUS)][i % (MEDIAN_STRIP + 2 * MAX_MEDIAN_RADIUS)] = 0;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// each work-item owns one column, fill in the window rows above the first output row
+	if (lid < num_columns) {
+		for (int y = y0 - radius; y < y0 + radius; y++) {
+			columns[channel_level(src_image, (int2)(halo_x + lid, y), channel)][lid]++;
+		}
+	}
+
+	for (int y = y0; y < y1; y++) {
+		// the row entering the window at the bottom, one update per column
+		if (lid < num_columns) {
+			columns[channel_level(src_image, (int2)(halo_x + lid, y + radius), channel)][lid]++;
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		// each work-item owns one bin and slides the window along the strip,
+		// one column is added and one removed per pixel whatever the radius
+		ushort count = 0;
+
+		for (int c = 0; c < window; c++) {
+			count += columns[lid][c];
+		}
+		windows[0][lid] = count;
+
+		for (int x = 1; x < MEDIAN_STRIP; x++) {
+			count += columns[lid][x + window - 1];
+			count -= columns[lid][x - 1];
+			windows[x][lid] = count;
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		// one work-item per output pixel walks its histogram to the middle rank
+		if (lid < MEDIAN_STRIP && x0 + lid < dim.x) {
+			int total = 0;
+			int level = 0;
+
+			while (level < MEDIAN_BINS - 1) {
+				total += windows[lid][level];
+				if (total >= rank)
+					break;
+				level++;
+			}
+
+			dst_buffer[(y * dim.x + x0 + lid) * 4 + channel] = (uchar)level;
+		}
+
+		// the row leaving the window at the top
+		if (lid < num_columns) {
+			columns[channel_level(src_image, (int2)(halo_x + lid, y - radius), channel)][lid]--;
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+}
+
+#define CLAHE_BINS 256			// one work-item per luminance level
+
+// 8-bit luminance level of the pixel at coord
+int luminance_level(read_only image2d_t src_image, int2 coord) {
+	float4 pixel = read_imagef(src_image, sampler, coord);
+
+	return convert_int_sat_rte((0.299f * pixel.x + 0.587f * pixel.y + 0.114f * pixel.z) * 255.0f);
+}
+
+__kernel __attribute__((reqd_work_group_size(CLAHE_BINS, 1, 1)))
+void clahe_tile_mapping(
+	read_only image2d_t src_image,
+	int tiles_x,
+	int tiles_y,
+	float clip_limit,
+	__global uchar* mappings
+) {
+	__local uint histogram[CLAHE_BINS];
+	__local uint scratch[CLAHE_BINS];
+
+	// one work-group per tile, each work-item owns one bin
+	int bin = get_local_id(0);
+	int tile = get_group_id(0);
+	int2 dim = get_image_dim(src_image);
+
+	// pixels covered by the tile, edge tiles may be smaller
+	int tile_width = (dim.x + tiles_x - 1) / tiles_x;
+	int tile_height = (dim.y + tiles_y - 1) / tiles_y;
+	int x0 = (tile % tiles_x) * tile_width;
+	int y0 = (tile / tiles_x) * tile_height;
+	int x1 = min(x0 + tile_width, dim.x);
+	int y1 = min(y0 + tile_height, dim.y);
+	int num_pixels = max((x1 - x0) * (y1 - y0), 1);
+
+	histogram[bin] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// build the tile histogram, work-items stride through the tile
+	for (int i = bin; i < (x1 - x0) * (y1 - y0); i += CLAHE_BINS) {
+		int2 coord = (int2)(x0 + i % (x1 - x0), y0 + i / (x1 - x0));
+		atomic_inc(&histogram[luminance_level(src_image, coord)]);
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// clip the bins to limit the contrast gain and total the excess
+	uint limit = max((uint)(clip_limit * num_pixels / CLAHE_BINS), (uint)1);
+	uint count = histogram[bin];
+	uint excess = count > limit ? count - limit : 0;
+	count -= excess;
+
+	scratch[bin] = excess;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int stride = CLAHE_BINS / 2; stride > 0; stride /= 2) {
+		if (bin < stride)
+			scratch[bin] += scratch[bin + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	// spread the excess evenly, the remainder goes to the lowest bins
+	uint total_excess = scratch[0];
+	count += total_excess / CLAHE_BINS + (bin < total_excess % CLAHE_BINS ? 1 : 0);
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// inclusive prefix sum of the clipped histogram gives the CDF
+	histogram[bin] = count;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int stride = 1; stride < CLAHE_BINS; stride *= 2) {
+		uint value = bin >= stride ? histogram[bin - stride] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		histogram[bin] += value;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	// the CDF scaled to 8 bits maps the tile's levels, empty tiles keep the levels unchanged
+	uint total = histogram[CLAHE_BINS - 1];
+	mappings[tile * CLAHE_BINS + bin] = total > 0 ? convert_uchar_sat_rte(histogram[bin] * 255.0f / total) : (uchar)bin;
+}
+
+__kernel void clahe_apply(
+	read_only image2d_t src_image,
+	__global const uchar* mappings,
+	int tiles_x,
+	int tiles_y,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+	int2 dim = get_image_dim(src_image);
+
+	// read pixel value
+	float4 pixel = read_imagef(src_image, sampler, coord);
+	float lum = 0.299f * pixel.x + 0.587f * pixel.y + 0.114f * pixel.z;
+	int level = convert_int_sat_rte(lum * 255.0f);
+
+	// position between tile centres, clamped so border pixels use the nearest tiles
+	float2 tile_size = (float2)((dim.x + tiles_x - 1) / tiles_x, (dim.y + tiles_y - 1) / tiles_y);
+	float2 pos = (convert_float2(coord) + 0.5f) / tile_size - 0.5f;
+	float2 max_tile = (float2)(tiles_x - 1, tiles_y - 1);
+	pos = clamp(pos, (float2)(0.0f), max_tile);
+
+	int2 t0 = convert_int2(floor(pos));
+	int2 t1 = min(t0 + 1, (int2)(tiles_x - 1, tiles_y - 1));
+	float2 f = pos - convert_float2(t0);
+
+	// bilinear blend of the four neighbouring tile mappings
+	float m00 = mappings[(t0.y * tiles_x + t0.x) * CLAHE_BINS + level];
+	float m10 = mappings[(t0.y * tiles_x + t1.x) * CLAHE_BINS + level];
+	float m01 = mappings[(t1.y * tiles_x + t0.x) * CLAHE_BINS + level];
+	float m11 = mappings[(t1.y * tiles_x + t1.x) * CLAHE_BINS + level];
+	float new_lum = mix(mix(m00, m10, f.x), mix(m01, m11, f.x), f.y) / 255.0f;
+
+	// scale the colour to the new luminance, black pixels become grey
+	if (lum > 0.0f)
+		pixel.xyz = clamp(pixel.xyz * (new_lum / lum), 0.0f, 1.0f);
+	else
+		pixel.xyz = (float3)(new_lum);
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, pixel);
+}
+
+#define MAX_COMPOSITE_LAYERS 4	// backdrop plus up to 3 layers per launch
+
+// blend modes, match BlendMode on the host
+#define BLEND_NORMAL 0		// layer over the result by its alpha
+#define BLEND_ADD 1			// bloom's add and clamp
+#define BLEND_MULTIPLY 2
+#define BLEND_SCREEN 3
+#define BLEND_LIGHTEN 4
+
+// blend mode and opacity of one layer, matches LayerBlend on the host
+typedef struct {
+	int mode;
+	float opacity;
+} LayerBlend;
+
+// blends one layer onto the result, the result keeps the backdrop's alpha
+float4 blend_layer(float4 result, float4 layer, LayerBlend blend) {
+	float3 blended;
+	float coverage = blend.opacity;
+
+	switch (blend.mode) {
+	case BLEND_ADD:
+		blended = result.xyz + layer.xyz;
+		break;
+	case BLEND_MULTIPLY:
+		blended = result.xyz * layer.xyz;
+		break;
+	case BLEND_SCREEN:
+		blended = 1.0f - (1.0f - result.xyz) * (1.0f - layer.xyz);
+		break;
+	case BLEND_LIGHTEN:
+		blended = fmax(result.xyz, layer.xyz);
+		break;
+	default:
+		// only the normal mode uses the layer's own alpha as coverage
+		blended = layer.xyz;
+		coverage *= layer.w;
+		break;
+	}
+
+	// clamp after every layer, as chaining two-input launches through 8-bit images would
+	result.xyz = clamp(mix(result.xyz, blended, coverage), 0.0f, 1.0f);
+
+	return result;
+}
+
+__kernel void composite_layers(
+	read_only image2d_t backdrop,
+	read_only image2d_t layer1,
+	read_only image2d_t layer2,
+	read_only image2d_t layer3,
+	__constant LayerBlend* blends,
+	int first_blend,
+	int num_layers,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// every layer is read once, unused layer arguments are never read
+	float4 result = read_imagef(backdrop, sampler, coord);
+
+	if (num_layers > 1)
+		result = blend_layer(result, read_imagef(layer1, sampler, coord), blends[first_blend + 0]);
+	if (num_layers > 2)
+		result = blend_layer(result, read_imagef(layer2, sampler, coord), blends[first_blend + 1]);
+	if (num_layers > 3)
+		result = blend_layer(result, read_imagef(layer3, sampler, coord), blends[first_blend + 2]);
+
+	// write new pixel value to output
+	write_imagef(dst_image, coord, result);
+}
+
+// looks up the graded colour of a pixel, one filtered fetch from the 3D LUT
+float4 grade_pixel(float4 pixel, read_only image3d_t lut, float4 domain_min, float4 domain_scale, float lut_size) {
+	// position of the colour inside the LUT domain
+	float4 pos = clamp((pixel - domain_min) * domain_scale, 0.0f, 1.0f);
+
+	// the first and last entries sit at texel centres, half a texel in from the edges
+	pos = (pos * (lut_size - 1.0f) + 0.5f) / lut_size;
+	pos.w = 0.0f;
+
+	float4 graded = read_imagef(lut, lut_sampler, pos);
+	graded.w = pixel.w;
+
+	return graded;
+}
+
+__kernel void apply_lut(
+	read_only image2d_t src_image,
+	read_only image3d_t lut,
+	float4 domain_min,
+	float4 domain_scale,
+	float lut_size,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// read pixel value
+	float4 pixel = read_imagef(src_image, sampler, coord);
+
+	// write graded pixel value to output
+	write_imagef(dst_image, coord, grade_pixel(pixel, lut, domain_min, domain_scale, lut_size));
+}
+
+__kernel void bloom_graded(
+	read_only image2d_t src_image,
+	read_only image2d_t src_image_blur,
+	read_only image3d_t lut,
+	float4 domain_min,
+	float4 domain_scale,
+	float lut_size,
+	write_only image2d_t dst_image
+) {
+	// get pixel coordinate
+	int2 coord = (int2) (get_global_id(0), get_global_id(1));
+
+	// bloom's add and clamp
+	float4 pixel = read_imagef(src_image, sampler, coord);
+	pixel.xyz = fmin(pixel.xyz + read_imagef(src_image_blur, sampler, coord).xyz, 1.0f);
+
+	// grade the bloomed pixel in the same pass
+	write_imagef(dst_image, coord, grade_pixel(pixel, lut, domain_min, domain_scale, lut_size));
+}
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <algorithm>
 
 // OpenCL header, depending on OS
 #ifdef __APPLE__
@@ -15,9 +16,81 @@
 
 #include "common.h"
 #include "bmpfuncs.h"
+#include "bloom.h"
+#include "metrics.h"
+#include "cube_lut.h"
 
 #define NUM_ITERATIONS 1000
 
+// blur modes for the glow
+#define BLUR_SEPARABLE 0		// 7-tap separable blur at full resolution
+#define BLUR_MIP_CHAIN 1		// progressive blur through a chain of half-resolution images
+#define BLUR_RECURSIVE 2		// recursive (IIR) Gaussian, cost independent of sigma
+#define BLUR_BOX 3				// box blur from a summed-area table, cost independent of radius
+
+#define BLUR_MODE BLUR_MIP_CHAIN
+#define MIP_LEVELS 5			// number of half-resolution levels, glow radius doubles per level
+#define IIR_SIGMA 8.0f			// standard deviation of the recursive Gaussian
+#define BOX_RADIUS 10			// radius of the box blur window
+#define BLUR_DOWNSCALE 2		// device blur modes run at 1/n resolution, 1 for full resolution
+
+// compare the fast blur path against a full-resolution float reference
+#define QUALITY_CHECK 1
+#define MIN_PSNR 30.0f			// quality floor in dB
+#define MIN_SSIM 0.95f
+
+// half-resolution previews of the input
+#define PYRAMID_LEVELS 3
+#define PYRAMID_FILTER RESIZE_LANCZOS
+
+// threshold modes for the glowing pixels
+#define THRESHOLD_GLOBAL 0		// fixed luminance threshold
+#define THRESHOLD_ADAPTIVE 1	// fixed threshold raised to the local mean plus deviation
+#define THRESHOLD_OTSU 2		// Otsu threshold from a luminance histogram, no user input
+
+#define THRESHOLD_MODE THRESHOLD_OTSU
+#define ADAPTIVE_RADIUS 15		// radius of the neighbourhood for the local statistics
+#define ADAPTIVE_K 1.0f			// number of local standard deviations above the mean
+
+// median filter against salt-and-pepper noise before thresholding, 0 to skip
+#define MEDIAN_RADIUS 1
+
+// adaptive histogram equalisation of low-contrast inputs before thresholding
+#define EQUALIZE_INPUT 0
+#define CLAHE_TILES 8			// tiles along each side
+#define CLAHE_CLIP 2.0f			// bin limit as a multiple of the mean bin count
+
+// clean-up of the glowing pixel mask before blurring
+#define MASK_CLEANUP 1
+#define MASK_OPERATION MORPH_OPEN	// opening removes isolated bright specks
+#define MASK_RADIUS 2				// radius of the square structuring element
+
+// bright blob measurement with connected-component labeling
+#define LABEL_COMPONENTS 1
+#define MAX_COMPONENTS 4096		// components beyond this are counted but not measured
+#define NUM_REPORTED 5			// largest components printed
+
+// bloom through the layer compositor instead of the two-input bloom kernel
+#define COMPOSITE_BLOOM 1
+
+// five-layer composite written to Task4f.bmp, takes chained launches of the compositor
+#define COMPOSITE_CHAIN_DEMO 0
+
+// colour grade with a 3D LUT, fused into the bloom pass or applied to the composited frame
+#define COLOUR_GRADE 1
+#define LUT_FILE "grade.cube"
+#define IDENTITY_LUT_SIZE 33	// used when the LUT file cannot be loaded
+
+// dirty-rectangle update: change part of the input and only recompute the pixels it affects
+#define DIRTY_REGION_DEMO 1
+#define DIRTY_SIZE 64			// width and height of the changed square
+
+// orders components by decreasing area
+bool larger_component(const ComponentStats& a, const ComponentStats& b)
+{
+	return a.area > b.area;
+}
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
@@ -29,14 +102,11 @@ int main(void)
 
 	// declare data and memory objects
 	unsigned char* inputImage;
-	unsigned char* inputImageLum;
-	unsigned char* inputImageBlurHorz;
-	unsigned char* inputImageBlurBoth;
 	unsigned char* outputImageLum;
 	unsigned char* outputImageBlur;
 	unsigned char* outputImage;
 	int imgWidth, imgHeight, imageSize;
-	float lum_t;
+	bool halfFloat;
 
 	cl::ImageFormat imgFormat;
 	cl::Image2D inputImgBuffer, inputImgBufferLum, inputImgBufferBlurHorz, inputImgBufferBlurBoth, outputImgBufferLum, outputImgBufferBlur, outputImgBuffer;
@@ -52,6 +122,13 @@ int main(void)
 		// create a context from device
 		context = cl::Context(device);
 
+		// store intermediate images as half floats if the device supports cl_khr_fp16
+		std::string supportedExtensions = device.getInfo<CL_DEVICE_EXTENSIONS>();
+		halfFloat = supportedExtensions.find("cl_khr_fp16") != std::string::npos;
+
+		std::cout << "Intermediate storage: " << (halfFloat ? "half float" : "float") << std::endl;
+		std::cout << "--------------------" << std::endl;
+
 		// build the program
 		if(!build_program(&program, &context, "task4.cl")) 
 		{
@@ -65,7 +142,9 @@ int main(void)
 		// create command queue
 		queue = cl::CommandQueue(context, device);
 
+#if THRESHOLD_MODE != THRESHOLD_OTSU
 		// read user's luminance threshold value
+		float lum_t;
 		std::cout << "Please enter a threshold value for luminance (0.0 - 1.0): ";
 		std::cin >> lum_t;
 		std::cout << std::endl;
@@ -73,6 +152,7 @@ int main(void)
 		if (lum_t < 0.0f || lum_t > 1.0f) {
 			quit_program("Invalid luminance range");
 		}
+#endif
 		
 		// read input image
 		inputImage = read_BMP_RGB_to_RGBA("peppers.bmp", &imgWidth, &imgHeight);
@@ -88,23 +168,86 @@ int main(void)
 
 		// create image objects
 		inputImgBuffer = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)inputImage);
-		outputImgBufferLum = cl::Image2D(context, CL_MEM_WRITE_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)outputImageLum);
-		outputImgBufferBlur = cl::Image2D(context, CL_MEM_WRITE_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)outputImageBlur);
+		outputImgBufferLum = cl::Image2D(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)outputImageLum);
+		outputImgBufferBlur = cl::Image2D(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)outputImageBlur);
 		outputImgBuffer = cl::Image2D(context, CL_MEM_WRITE_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)outputImage);
 
+		cl::NDRange offset(0, 0);
+		cl::NDRange globalSize(imgWidth, imgHeight);
+
+		// thresholding reads a denoised copy, bloom still adds the glow to the original
+		cl::Image2D thresholdSrc = inputImgBuffer;
+
+#if MEDIAN_RADIUS > 0
+		thresholdSrc = cl::Image2D(context, CL_MEM_READ_WRITE, imgFormat, imgWidth, imgHeight);
+		median_filter(&context, &queue, &program, &inputImgBuffer, &thresholdSrc, imgWidth, imgHeight, MEDIAN_RADIUS);
+
+		std::cout << "Median Filter Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#endif
+
+#if EQUALIZE_INPUT
+		{
+			cl::Image2D equalized(context, CL_MEM_READ_WRITE, imgFormat, imgWidth, imgHeight);
+			clahe(&context, &queue, &program, &thresholdSrc, &equalized, imgWidth, imgHeight, CLAHE_TILES, CLAHE_TILES, CLAHE_CLIP, full_region(imgWidth, imgHeight));
+			thresholdSrc = equalized;
+		}
+
+		std::cout << "CLAHE Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#endif
+
+#if THRESHOLD_MODE == THRESHOLD_OTSU
+		// threshold computed on the device from the luminance histogram
+		otsu_glowing_pixels(&context, &queue, &program, &thresholdSrc, &outputImgBufferLum, imgWidth, imgHeight, full_region(imgWidth, imgHeight));
+
+		std::cout << "Otsu Glowing Pixels Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#elif THRESHOLD_MODE == THRESHOLD_ADAPTIVE
+		// threshold against the local statistics from a summed-area table
+		adaptive_glowing_pixels(&context, &queue, &program, &thresholdSrc, &outputImgBufferLum, imgWidth, imgHeight, lum_t, ADAPTIVE_RADIUS, ADAPTIVE_K, full_region(imgWidth, imgHeight));
+
+		std::cout << "Adaptive Glowing Pixels Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#else
 		// set kernel arguments
-		kernel.setArg(0, inputImgBuffer);
+		kernel.setArg(0, thresholdSrc);
 		kernel.setArg(1, lum_t);
 		kernel.setArg(2, outputImgBufferLum);
 		
-		// enqueue kernel for horizontal pass
-		cl::NDRange offset(0, 0);
-		cl::NDRange globalSize(imgWidth, imgHeight);
-
+		// enqueue kernel for glowing pixels
 		queue.enqueueNDRangeKernel(kernel, offset, globalSize);
 
 		std::cout << "Glowing Pixels Kernel enqueued." << std::endl;
 		std::cout << "--------------------" << std::endl;
+#endif
+
+#if MASK_CLEANUP
+		// remove small specks from the mask, cost does not grow with the radius
+		morphology(&context, &queue, &program, &outputImgBufferLum, &outputImgBufferLum, imgWidth, imgHeight, MASK_RADIUS, MASK_OPERATION);
+
+		std::cout << "Mask Morphology Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#endif
+
+#if LABEL_COMPONENTS
+		{
+			// label the bright blobs, only their statistics come back to the host
+			std::vector<ComponentStats> components(MAX_COMPONENTS);
+			int numComponents = label_components(&context, &queue, &program, &outputImgBufferLum, imgWidth, imgHeight, &components[0], MAX_COMPONENTS);
+			int numMeasured = numComponents < MAX_COMPONENTS ? numComponents : MAX_COMPONENTS;
+
+			std::sort(components.begin(), components.begin() + numMeasured, larger_component);
+
+			std::cout << "Bright components: " << numComponents << std::endl;
+			for (int i = 0; i < numMeasured && i < NUM_REPORTED; i++) {
+				ComponentStats* c = &components[i];
+				std::cout << "  area " << c->area << ", box (" << c->minX << ", " << c->minY << ")-(" << c->maxX << ", " << c->maxY
+					<< "), mean luminance " << c->lumSum / (255.0f * c->area) << std::endl;
+			}
+			std::cout << "--------------------" << std::endl;
+		}
+#endif
 
 		// enqueue command to read image from device to host memory
 		cl::size_t<3> origin, region;
@@ -119,8 +262,89 @@ int main(void)
 		// output results to image file
 		write_BMP_RGBA_to_RGB("Task4a.bmp", outputImageLum, imgWidth, imgHeight);
 
+#if BLUR_MODE != BLUR_SEPARABLE
+		// the device blurs run between these images, reduced copies of the mask when downscaling
+		int blurWidth = imgWidth / BLUR_DOWNSCALE;
+		int blurHeight = imgHeight / BLUR_DOWNSCALE;
+		cl::Image2D blurSrc = outputImgBufferLum;
+		cl::Image2D blurDst = outputImgBufferBlur;
+
+		// every halving of the resolution replaces one mip level
+		int downscaleLevels = 0;
+		for (int scale = BLUR_DOWNSCALE; scale > 1; scale /= 2)
+			downscaleLevels++;
+
+		int mipLevels = MIP_LEVELS - downscaleLevels > 1 ? MIP_LEVELS - downscaleLevels : 1;
+
+#if BLUR_DOWNSCALE > 1
+		blurSrc = cl::Image2D(context, CL_MEM_READ_WRITE, imgFormat, blurWidth, blurHeight);
+		blurDst = cl::Image2D(context, CL_MEM_READ_WRITE, imgFormat, blurWidth, blurHeight);
+
+		// averaging keeps small bright spots in the reduced mask
+		resize_image(&context, &queue, &program, &outputImgBufferLum, imgWidth, imgHeight, &blurSrc, blurWidth, blurHeight, RESIZE_BOX);
+#endif
+#endif
+
+#if BLUR_MODE == BLUR_MIP_CHAIN
+		// blur the glowing pixels through the mip chain, the result stays on the device
+		mip_chain_blur(&context, &queue, &program, &blurSrc, &blurDst, blurWidth, blurHeight, mipLevels, 0, halfFloat, full_region(blurWidth, blurHeight));
+
+		std::cout << "Mip chain blurring Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#elif BLUR_MODE == BLUR_RECURSIVE
+		// blur the glowing pixels with the recursive Gaussian, the result stays on the device
+		recursive_gaussian_blur(&context, &queue, &program, &blurSrc, &blurDst, blurWidth, blurHeight, IIR_SIGMA / BLUR_DOWNSCALE, halfFloat);
+
+		std::cout << "Recursive Gaussian blurring Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#elif BLUR_MODE == BLUR_BOX
+		// box blur the glowing pixels from a summed-area table, the result stays on the device
+		box_blur(&context, &queue, &program, &blurSrc, &blurDst, blurWidth, blurHeight, BOX_RADIUS / BLUR_DOWNSCALE, full_region(blurWidth, blurHeight));
+
+		std::cout << "Box blurring Kernels enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+#endif
+
+#if BLUR_MODE != BLUR_SEPARABLE
+#if BLUR_DOWNSCALE > 1
+		// the blurred glow is smooth, so bilinear upscaling is enough
+		resize_image(&context, &queue, &program, &blurDst, blurWidth, blurHeight, &outputImgBufferBlur, imgWidth, imgHeight, RESIZE_BILINEAR);
+#endif
+
+#if QUALITY_CHECK
+		{
+			// same blur at full resolution with float intermediates
+			cl::Image2D referenceBlur(context, CL_MEM_READ_WRITE, imgFormat, imgWidth, imgHeight);
+#if BLUR_MODE == BLUR_MIP_CHAIN
+			// the same levels as the reduced chain, the full resolution levels it never sees are left out
+			mip_chain_blur(&context, &queue, &program, &outputImgBufferLum, &referenceBlur, imgWidth, imgHeight,
+				mipLevels + downscaleLevels, downscaleLevels, false, full_region(imgWidth, imgHeight));
+#elif BLUR_MODE == BLUR_RECURSIVE
+			recursive_gaussian_blur(&context, &queue, &program, &outputImgBufferLum, &referenceBlur, imgWidth, imgHeight, IIR_SIGMA, false);
+#elif BLUR_MODE == BLUR_BOX
+			box_blur(&context, &queue, &program, &outputImgBufferLum, &referenceBlur, imgWidth, imgHeight, BOX_RADIUS, full_region(imgWidth, imgHeight));
+#endif
+
+			// only the two scalars leave the device
+			float psnr = compute_psnr(&context, &queue, &program, &referenceBlur, &outputImgBufferBlur, imgWidth, imgHeight);
+			float ssim = compute_ssim(&context, &queue, &program, &referenceBlur, &outputImgBufferBlur, imgWidth, imgHeight);
+
+			std::cout << "Blur quality against reference: PSNR " << psnr << " dB, SSIM " << ssim << std::endl;
+			std::cout << (meets_quality_floor(psnr, ssim, MIN_PSNR, MIN_SSIM) ? "Within" : "Below") << " the quality floor." << std::endl;
+			std::cout << "--------------------" << std::endl;
+		}
+#endif
+
+		// enqueue command to read image from device to host memory
+		queue.enqueueReadImage(outputImgBufferBlur, CL_TRUE, origin, region, 0, 0, outputImageBlur);
+
+		// output results to image file
+		write_BMP_RGBA_to_RGB("Task4c.bmp", outputImageBlur, imgWidth, imgHeight);
+
+		inputImgBufferBlurBoth = outputImgBufferBlur;
+#else
 		// read input image (lum)
-		inputImageLum = read_BMP_RGB_to_RGBA("Task4a.bmp", &imgWidth, &imgHeight);
+		unsigned char* inputImageLum = read_BMP_RGB_to_RGBA("Task4a.bmp", &imgWidth, &imgHeight);
 		inputImgBufferLum = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)inputImageLum);
 
 		// set kernel for blurring task
@@ -144,7 +368,7 @@ int main(void)
 		write_BMP_RGBA_to_RGB("Task4b.bmp", outputImageBlur, imgWidth, imgHeight);
 
 		// read input image (BlurHorz)
-		inputImageBlurHorz = read_BMP_RGB_to_RGBA("Task4b.bmp", &imgWidth, &imgHeight);
+		unsigned char* inputImageBlurHorz = read_BMP_RGB_to_RGBA("Task4b.bmp", &imgWidth, &imgHeight);
 		inputImgBufferBlurHorz = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)inputImageBlurHorz);
 
 		// set kernel arguments for vertical pass
@@ -165,9 +389,54 @@ int main(void)
 		write_BMP_RGBA_to_RGB("Task4c.bmp", outputImageBlur, imgWidth, imgHeight);
 
 		// read input image (BlurBoth)
-		inputImageBlurBoth = read_BMP_RGB_to_RGBA("Task4c.bmp", &imgWidth, &imgHeight);
+		unsigned char* inputImageBlurBoth = read_BMP_RGB_to_RGBA("Task4c.bmp", &imgWidth, &imgHeight);
 		inputImgBufferBlurBoth = cl::Image2D(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, imgFormat, imgWidth, imgHeight, 0, (void*)inputImageBlurBoth);
+#endif
+
+#if COLOUR_GRADE
+		// .cube files hold 17, 33 or 65 entries per axis
+		CubeLut lut;
+		if (!load_cube_lut(LUT_FILE, &lut))
+		{
+			std::cout << "Grading with an identity LUT." << std::endl;
+			identity_cube_lut(IDENTITY_LUT_SIZE, &lut);
+		}
+
+		cl::Image3D lutImage = create_lut_image(&context, &lut);
+#endif
+
+#if COMPOSITE_BLOOM
+		{
+			// glow added over the input, further layers can be appended to the table
+			const cl::Image2D* layers[] = { &inputImgBuffer, &inputImgBufferBlurBoth };
+			LayerBlend blends[] = { { BLEND_ADD, 1.0f } };
+			int numLayers = sizeof(layers) / sizeof(layers[0]);
+
+#if COLOUR_GRADE
+			// grade the composited frame, the output image is write only so composite into a temporary
+			cl::Image2D composited(context, CL_MEM_READ_WRITE, imgFormat, imgWidth, imgHeight);
+			composite_layers(&context, &queue, &program, layers, blends, numLayers, &composited, imgWidth, imgHeight, full_region(imgWidth, imgHeight));
+
+			kernel = cl::Kernel(program, "apply_lut");
+			kernel.setArg(0, composited);
+			set_lut_args(&kernel, 1, &lutImage, &lut);
+			kernel.setArg(5, outputImgBuffer);
+
+			queue.enqueueNDRangeKernel(kernel, offset, globalSize);
+#else
+			composite_layers(&context, &queue, &program, layers, blends, numLayers, &outputImgBuffer, imgWidth, imgHeight, full_region(imgWidth, imgHeight));
+#endif
+		}
+#elif COLOUR_GRADE
+		// bloom and grade in one pass, one LUT fetch per pixel
+		kernel = cl::Kernel(program, "bloom_graded");
+		kernel.setArg(0, inputImgBuffer);
+		kernel.setArg(1, inputImgBufferBlurBoth);
+		set_lut_args(&kernel, 2, &lutImage, &lut);
+		kernel.setArg(6, outputImgBuffer);
 
+		queue.enqueueNDRangeKernel(kernel, offset, globalSize);
+#else
 		// set kernel for bloom effect
 		kernel = cl::Kernel(program, "bloom");
 
@@ -178,6 +447,7 @@ int main(void)
 
 		// enqueue kernel for bloom
 		queue.enqueueNDRangeKernel(kernel, offset, globalSize);
+#endif
 
 		std::cout << "Bloom Kernel enqueued." << std::endl;
 		std::cout << "--------------------" << std::endl;
@@ -188,6 +458,128 @@ int main(void)
 		// output results to image file
 		write_BMP_RGBA_to_RGB("Task4d.bmp", outputImage, imgWidth, imgHeight);
 
+#if COMPOSITE_CHAIN_DEMO
+		{
+			// bloom with the glow mask and a softer glow as extra layers, more layers than one launch blends
+			const cl::Image2D* layers[] = { &inputImgBuffer, &inputImgBufferBlurBoth, &outputImgBufferLum, &inputImgBufferBlurBoth, &inputImgBuffer };
+			LayerBlend blends[] = { { BLEND_ADD, 1.0f }, { BLEND_SCREEN, 0.25f }, { BLEND_LIGHTEN, 0.5f }, { BLEND_MULTIPLY, 0.2f } };
+			int numLayers = sizeof(layers) / sizeof(layers[0]);
+
+			cl::Image2D chained(context, CL_MEM_READ_WRITE, imgFormat, imgWidth, imgHeight);
+			composite_layers(&context, &queue, &program, layers, blends, numLayers, &chained, imgWidth, imgHeight, full_region(imgWidth, imgHeight));
+
+			// enqueue command to read image from device to host memory
+			queue.enqueueReadImage(chained, CL_TRUE, origin, region, 0, 0, outputImage);
+
+			// output results to image file
+			write_BMP_RGBA_to_RGB("Task4f.bmp", outputImage, imgWidth, imgHeight);
+
+			std::cout << "Chained Composite Kernels enqueued." << std::endl;
+			std::cout << "--------------------" << std::endl;
+		}
+#endif
+
+#if PYRAMID_LEVELS > 0
+		{
+			// previews of the input at half, quarter and smaller sizes
+			ImagePyramid pyramid;
+			build_pyramid(&context, &queue, &program, &inputImgBuffer, imgWidth, imgHeight, PYRAMID_LEVELS, PYRAMID_FILTER, &pyramid);
+
+			for (int i = 1; i <= PYRAMID_LEVELS; i++) {
+				cl::size_t<3> levelRegion;
+				levelRegion[0] = pyramid.widths[i];
+				levelRegion[1] = pyramid.heights[i];
+				levelRegion[2] = 1;
+
+				unsigned char* levelImage = new unsigned char[pyramid.widths[i] * pyramid.heights[i] * 4];
+				queue.enqueueReadImage(pyramid.levels[i], CL_TRUE, origin, levelRegion, 0, 0, levelImage);
+
+				std::stringstream filename;
+				filename << "Task4_level" << i << ".bmp";
+				write_BMP_RGBA_to_RGB(filename.str().c_str(), levelImage, pyramid.widths[i], pyramid.heights[i]);
+
+				delete[] levelImage;
+			}
+
+			std::cout << "Pyramid of " << PYRAMID_LEVELS << " levels written." << std::endl;
+			std::cout << "--------------------" << std::endl;
+		}
+#endif
+
+#if DIRTY_REGION_DEMO
+		{
+			BloomCache cache;			// reused between frames, only dirty pixels are recomputed
+			BloomCache reference;		// recomputed in full to check the incremental result
+			Region full = { 0, 0, imgWidth, imgHeight };
+			Region dirty = { imgWidth / 2 - DIRTY_SIZE / 2, imgHeight / 2 - DIRTY_SIZE / 2, DIRTY_SIZE, DIRTY_SIZE };
+			dirty = expand_region(dirty, 0, 0, imgWidth, imgHeight);
+
+			create_bloom_cache(&context, &cache, imgWidth, imgHeight);
+			create_bloom_cache(&context, &reference, imgWidth, imgHeight);
+
+			// keep the threshold fixed between frames so that clean pixels stay valid
+#if THRESHOLD_MODE == THRESHOLD_OTSU
+			otsu_threshold(&context, &queue, &program, &inputImgBuffer, &cache.threshold, imgWidth, imgHeight);
+			queue.enqueueCopyBuffer(cache.threshold, reference.threshold, 0, 0, sizeof(cl_float));
+#else
+			queue.enqueueWriteBuffer(cache.threshold, CL_FALSE, 0, sizeof(cl_float), &lum_t);
+			queue.enqueueWriteBuffer(reference.threshold, CL_FALSE, 0, sizeof(cl_float), &lum_t);
+#endif
+
+			// first frame fills the whole cache
+			update_bloom_region(&queue, &program, &inputImgBuffer, &cache, full);
+
+			// brighten a square in the middle of the image on the host
+			for (int y = dirty.y; y < dirty.y + dirty.height; y++) {
+				for (int x = dirty.x; x < dirty.x + dirty.width; x++) {
+					for (int c = 0; c < 3; c++) {
+						unsigned char* value = &inputImage[(y * imgWidth + x) * 4 + c];
+						*value = *value > 127 ? 255 : *value * 2;
+					}
+				}
+			}
+
+			// upload only the changed rows and columns
+			cl::size_t<3> dirtyOrigin;
+			dirtyOrigin[0] = dirty.x;
+			dirtyOrigin[1] = dirty.y;
+			dirtyOrigin[2] = 0;
+			cl::size_t<3> dirtySize;
+			dirtySize[0] = dirty.width;
+			dirtySize[1] = dirty.height;
+			dirtySize[2] = 1;
+
+			queue.enqueueWriteImage(inputImgBuffer, CL_FALSE, dirtyOrigin, dirtySize, imgWidth * 4, 0,
+				&inputImage[(dirty.y * imgWidth + dirty.x) * 4]);
+
+			// second frame only touches the dirty square and its blur halo
+			update_bloom_region(&queue, &program, &inputImgBuffer, &cache, dirty);
+			update_bloom_region(&queue, &program, &inputImgBuffer, &reference, full);
+
+			// compare the incremental result with the full recompute
+			unsigned char* referenceImage = new unsigned char[imageSize];
+			queue.enqueueReadImage(cache.output, CL_TRUE, origin, region, 0, 0, outputImage);
+			queue.enqueueReadImage(reference.output, CL_TRUE, origin, region, 0, 0, referenceImage);
+
+			int mismatches = 0;
+			for (int i = 0; i < imageSize; i++) {
+				if (outputImage[i] != referenceImage[i])
+					mismatches++;
+			}
+
+			Region halo = expand_region(dirty, 3, 3, imgWidth, imgHeight);
+			std::cout << "Dirty region: " << dirty.width << "x" << dirty.height << " at (" << dirty.x << ", " << dirty.y << "), "
+				<< halo.width * halo.height << " of " << imgWidth * imgHeight << " pixels recomputed" << std::endl;
+			std::cout << "Mismatches against full recompute: " << mismatches << std::endl;
+			std::cout << "--------------------" << std::endl;
+
+			// output results to image file
+			write_BMP_RGBA_to_RGB("Task4e.bmp", outputImage, imgWidth, imgHeight);
+
+			delete[] referenceImage;
+		}
+#endif
+
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
@@ -1,6 +1,16 @@
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | 
       CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST; 
 
+__constant sampler_t linear_sampler = CLK_NORMALIZED_COORDS_FALSE | 
+      CLK_ADDRESS_CLAMP | CLK_FILTER_LINEAR; 
+
+// interpolation modes for warp_image
+#define INTERPOLATION_BILINEAR 0
+#define INTERPOLATION_BICUBIC 1
+
+// output pixels computed by each warp_image work-item along a row
+#define WARP_RUN_LENGTH 16
+
 __kernel void rotate_image(read_only image2d_t src_image,
 					write_only image2d_t dst_image,
 					float sin_theta,
@@ -27,3 +37,85 @@ __kernel void rotate_image(read_only image2d_t src_image,
    // write new pixel value to output
    write_imagef(dst_image, coord, pixel);
 }
+
+// Catmull-Rom weights of the four taps around fractional position t
+float4 cubic_weights(float t) {
+   float t2 = t * t;
+   float t3 = t2 * t;
+
+   return (float4)(-0.5f * t3 + t2 - 0.5f * t,
+                    1.5f * t3 - 2.5f * t2 + 1.0f,
+                   -1.5f * t3 + 2.0f * t2 + 0.5f * t,
+                    0.5f * t3 - 0.5f * t2);
+}
+
+// weighted sum of four horizontally neighbouring pixels starting at coord
+float4 cubic_row(read_only image2d_t src_image, int2 coord, float4 wx) {
+   return wx.x * read_imagef(src_image, sampler, coord) +
+          wx.y * read_imagef(src_image, sampler, coord + (int2)(1, 0)) +
+          wx.z * read_imagef(src_image, sampler, coord + (int2)(2, 0)) +
+          wx.w * read_imagef(src_image, sampler, coord + (int2)(3, 0));
+}
+
+// bicubic sample at pos, pixel centres are at integer + 0.5
+float4 read_bicubic(read_only image2d_t src_image, float2 pos) {
+   float2 p = pos - 0.5f;
+   float2 base = floor(p);
+   float2 f = p - base;
+
+   float4 wx = cubic_weights(f.x);
+   float4 wy = cubic_weights(f.y);
+
+   // top-left pixel of the 4x4 neighbourhood
+   int2 coord = convert_int2(base) - 1;
+
+   float4 sum = wy.x * cubic_row(src_image, coord, wx) +
+                wy.y * cubic_row(src_image, coord + (int2)(0, 1), wx) +
+                wy.z * cubic_row(src_image, coord + (int2)(0, 2), wx) +
+                wy.w * cubic_row(src_image, coord + (int2)(0, 3), wx);
+
+   // Catmull-Rom can overshoot at sharp edges
+   return clamp(sum, 0.0f, 1.0f);
+}
+
+__kernel void warp_image(read_only image2d_t src_image,
+					write_only image2d_array_t dst_images,
+					__constant float* inverse_matrices,
+					int interpolation) {
+
+   // first pixel of this work-item's run, the row and the transform (output slice)
+   int first = get_global_id(0) * WARP_RUN_LENGTH;
+   int row = get_global_id(1);
+   int slice = get_global_id(2);
+
+   // 3x3 row-major matrix mapping output pixels to source pixels
+   __constant float* m = inverse_matrices + slice * 9;
+
+   // homogeneous source position of the first pixel centre
+   float x = first + 0.5f;
+   float y = row + 0.5f;
+   float3 pos = (float3)(m[0] * x + m[1] * y + m[2],
+                         m[3] * x + m[4] * y + m[5],
+                         m[6] * x + m[7] * y + m[8]);
+
+   // moving one pixel along the row adds the first column of the matrix
+   float3 step = (float3)(m[0], m[3], m[6]);
+
+   int last = min(first + WARP_RUN_LENGTH, (int)get_image_width(dst_images));
+   float4 pixel;
+
+   for(int column = first; column < last; column++) {
+      float2 src_pos = pos.xy / pos.z;
+
+      // read pixel value, outside the source is the black border colour
+      if(interpolation == INTERPOLATION_BICUBIC)
+         pixel = read_bicubic(src_image, src_pos);
+      else
+         pixel = read_imagef(src_image, linear_sampler, src_pos);
+
+      // write new pixel value to output
+      write_imagef(dst_images, (int4)(column, row, slice, 0), pixel);
+
+      pos += step;
+   }
+}
\ No newline at end of file
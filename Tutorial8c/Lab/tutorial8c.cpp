@@ -6,6 +6,8 @@
 #include <vector>
 #include <fstream>
 #include <cmath>
+#include <string>
+#include <algorithm>
 
 // OpenCL header, depending on OS
 #ifdef __APPLE__
@@ -17,6 +19,53 @@
 #include "common.h"
 #include "bmpfuncs.h"
 
+#define PI 3.14159265358979f
+#define NUM_WARPS 3				// transforms applied in one warp_image launch
+#define WARP_RUN_LENGTH 16		// must match WARP_RUN_LENGTH in rotate.cl
+#define INTERPOLATION 1			// 0 for bilinear, 1 for bicubic
+
+// multiplies two 3x3 row-major matrices, out = a * b
+void multiply_matrix(const float* a, const float* b, float* out)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			out[i * 3 + j] = a[i * 3] * b[j] + a[i * 3 + 1] * b[3 + j] + a[i * 3 + 2] * b[6 + j];
+		}
+	}
+}
+
+// inverts a 3x3 row-major matrix, returns false if it is singular
+bool invert_matrix(const float* m, float* out)
+{
+	float det = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+
+	if (fabs(det) < 1e-12f)
+		return false;
+
+	out[0] = (m[4] * m[8] - m[5] * m[7]) / det;
+	out[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+	out[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+	out[3] = (m[5] * m[6] - m[3] * m[8]) / det;
+	out[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+	out[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+	out[6] = (m[3] * m[7] - m[4] * m[6]) / det;
+	out[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+	out[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+
+	return true;
+}
+
+// applies a 3x3 homography to the point (x, y)
+void transform_point(const float* m, float x, float y, float* outX, float* outY)
+{
+	float w = m[6] * x + m[7] * y + m[8];
+
+	*outX = (m[0] * x + m[1] * y + m[2]) / w;
+	*outY = (m[3] * x + m[4] * y + m[5]) / w;
+}
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
@@ -31,12 +80,27 @@ int main(void)
 	unsigned char* outputImage;
 	int imgWidth, imgHeight, imageSize;
 	int theta = 45;
-	cl_float sin_theta = sinf(theta);
-	cl_float cos_theta = cosf(theta);
+	cl_float sin_theta = sinf(theta * PI / 180.0f);		// sinf and cosf take radians
+	cl_float cos_theta = cosf(theta * PI / 180.0f);
 
 	cl::ImageFormat imgFormat;
 	cl::Image2D inputImgBuffer, outputImgBuffer;
 
+	// warp transforms as 3x3 row-major homographies, an affine matrix has a last row of (0, 0, 1)
+	float warps[NUM_WARPS][9] = {
+		// rotation by theta
+		{ cos_theta, -sin_theta, 0.0f, sin_theta, cos_theta, 0.0f, 0.0f, 0.0f, 1.0f },
+		// affine shear and scale
+		{ 1.2f, 0.3f, 0.0f, 0.1f, 0.9f, 0.0f, 0.0f, 0.0f, 1.0f },
+		// perspective keystone
+		{ 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0008f, 0.0f, 1.0f }
+	};
+	std::vector<cl_float> inverseWarps(NUM_WARPS * 9);
+	int warpWidth, warpHeight;
+	unsigned char* warpImage;
+	cl::Image2DArray warpImgBuffer;
+	cl::Buffer warpMatrixBuffer;
+
 	try {
 		// select an OpenCL device
 		if (!select_one_device(&platform, &device))
@@ -102,11 +166,95 @@ int main(void)
 		// output results to image file
 		write_BMP_RGBA_to_RGB("output.bmp", outputImage, imgWidth, imgHeight);
 
+		// centre every warp on the image centre and find its bounding box
+		float centre[9] = { 1.0f, 0.0f, -imgWidth / 2.0f, 0.0f, 1.0f, -imgHeight / 2.0f, 0.0f, 0.0f, 1.0f };
+		float minX[NUM_WARPS], minY[NUM_WARPS], maxX[NUM_WARPS], maxY[NUM_WARPS];
+		float centred[NUM_WARPS][9];
+		warpWidth = warpHeight = 0;
+
+		for (int i = 0; i < NUM_WARPS; i++)
+		{
+			multiply_matrix(warps[i], centre, centred[i]);
+
+			minX[i] = minY[i] = 1e30f;
+			maxX[i] = maxY[i] = -1e30f;
+
+			for (int c = 0; c < 4; c++)
+			{
+				float x, y;
+				transform_point(centred[i], (c & 1) ? (float)imgWidth : 0.0f, (c & 2) ? (float)imgHeight : 0.0f, &x, &y);
+
+				minX[i] = fminf(minX[i], x);
+				minY[i] = fminf(minY[i], y);
+				maxX[i] = fmaxf(maxX[i], x);
+				maxY[i] = fmaxf(maxY[i], y);
+			}
+
+			// output size fits every warp so nothing is cropped
+			warpWidth = std::max(warpWidth, (int)ceilf(maxX[i] - minX[i]));
+			warpHeight = std::max(warpHeight, (int)ceilf(maxY[i] - minY[i]));
+		}
+
+		// move each bounding box to the centre of the output and invert for the kernel
+		for (int i = 0; i < NUM_WARPS; i++)
+		{
+			float shift[9] = { 1.0f, 0.0f, warpWidth / 2.0f - (minX[i] + maxX[i]) / 2.0f,
+							   0.0f, 1.0f, warpHeight / 2.0f - (minY[i] + maxY[i]) / 2.0f,
+							   0.0f, 0.0f, 1.0f };
+			float forward[9];
+
+			multiply_matrix(shift, centred[i], forward);
+
+			if (!invert_matrix(forward, &inverseWarps[i * 9]))
+			{
+				quit_program("Warp matrix is not invertible.");
+			}
+		}
+
+		// create a kernel that applies all warps in one launch
+		kernel = cl::Kernel(program, "warp_image");
+
+		warpImage = new unsigned char[warpWidth * warpHeight * 4];
+		warpMatrixBuffer = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_float) * inverseWarps.size(), &inverseWarps[0]);
+		warpImgBuffer = cl::Image2DArray(context, CL_MEM_WRITE_ONLY, imgFormat, NUM_WARPS, warpWidth, warpHeight, 0, 0);
+
+		// set kernel arguments
+		kernel.setArg(0, inputImgBuffer);
+		kernel.setArg(1, warpImgBuffer);
+		kernel.setArg(2, warpMatrixBuffer);
+		kernel.setArg(3, INTERPOLATION);
+
+		// each work-item steps along a run of pixels in one row of one warp
+		cl::NDRange warpOffset(0, 0, 0);
+		cl::NDRange warpGlobalSize((warpWidth + WARP_RUN_LENGTH - 1) / WARP_RUN_LENGTH, warpHeight, NUM_WARPS);
+
+		queue.enqueueNDRangeKernel(kernel, warpOffset, warpGlobalSize);
+
+		std::cout << "Warp Kernel enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// read each warp's slice and output it to an image file
+		for (int i = 0; i < NUM_WARPS; i++)
+		{
+			cl::size_t<3> warpOrigin, warpRegion;
+			warpOrigin[0] = warpOrigin[1] = 0;
+			warpOrigin[2] = i;
+			warpRegion[0] = warpWidth;
+			warpRegion[1] = warpHeight;
+			warpRegion[2] = 1;
+
+			queue.enqueueReadImage(warpImgBuffer, CL_TRUE, warpOrigin, warpRegion, 0, 0, warpImage);
+
+			std::string filename = "warp_" + std::to_string(i) + ".bmp";
+			write_BMP_RGBA_to_RGB(filename.c_str(), warpImage, warpWidth, warpHeight);
+		}
+
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
 		free(inputImage);
 		free(outputImage);
+		delete[] warpImage;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {
@@ -5,6 +5,10 @@ __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE |
 __constant float vSobelFilter[9] = {-1.0, -2.0, -1.0, 
 									 0.0,  0.0,  0.0, 
 									 1.0,  2.0,  1.0};
+// 3x3 Horizontal Sobel edge detection filter
+__constant float hSobelFilter[9] = {-1.0, 0.0, 1.0, 
+									-2.0, 0.0, 2.0, 
+									-1.0, 0.0, 1.0};
 // 3x3 Blurring filter
 __constant float BlurringFilter[9] = {	1.0/9, 1.0/9, 1.0/9, 
 										1.0/9, 1.0/9, 1.0/9, 
@@ -49,4 +53,291 @@ __kernel void simple_conv(read_only image2d_t src_image,
    // write new pixel value to output
    coord = (int2)(column, row); 
    write_imagef(dst_image, coord, sum);
-}
\ No newline at end of file
+}
+
+// work-group width and height for tiled kernels
+#define TILE_SIZE 16
+
+// loads the work-group's tile of luminance values plus a one pixel halo into local memory
+void load_luminance_tile(read_only image2d_t src_image,
+					__local float tile[TILE_SIZE + 2][TILE_SIZE + 2]) {
+
+   // top-left pixel of the tile including the halo
+   int2 origin = (int2)(get_group_id(0) * TILE_SIZE - 1, get_group_id(1) * TILE_SIZE - 1);
+
+   int lid = get_local_id(1) * TILE_SIZE + get_local_id(0);
+
+   // single channel images already hold a luminance
+   int single_channel = get_image_channel_order(src_image) == CLK_R;
+
+   // each work-item loads every (TILE_SIZE * TILE_SIZE)th tile element
+   for(int i = lid; i < (TILE_SIZE + 2) * (TILE_SIZE + 2); i += TILE_SIZE * TILE_SIZE) {
+      int2 offset = (int2)(i % (TILE_SIZE + 2), i / (TILE_SIZE + 2));
+
+      // read value pixel from the image
+      float4 pixel = read_imagef(src_image, sampler, origin + offset);
+
+      tile[offset.y][offset.x] = single_channel ? pixel.x : 0.299f * pixel.x + 0.587f * pixel.y + 0.114f * pixel.z;
+   }
+
+   barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+__kernel void sobel_gradient(read_only image2d_t src_image,
+					write_only image2d_t magnitude_image,
+					write_only image2d_t orientation_image) {
+
+   __local float tile[TILE_SIZE + 2][TILE_SIZE + 2];
+
+   // every pixel of the neighbourhood is read from the image once per tile
+   load_luminance_tile(src_image, tile);
+
+   // get work-item’s row and column position
+   int column = get_global_id(0); 
+   int row = get_global_id(1);
+
+   // global size is rounded up to whole tiles
+   int2 dim = get_image_dim(src_image);
+   if(column >= dim.x || row >= dim.y)
+      return;
+
+   // work-item's position in the tile, offset by the halo
+   int tx = get_local_id(0) + 1;
+   int ty = get_local_id(1) + 1;
+
+   // accumulated gradients
+   float gx = 0.0f;
+   float gy = 0.0f;
+
+   // filter's current index
+   int filter_index =  0;
+
+   // both filters share the same neighbourhood
+   for(int i = -1; i <= 1; i++) {
+      for(int j = -1; j <= 1; j++) {
+         float lum = tile[ty + i][tx + j];
+
+         gx += lum * hSobelFilter[filter_index];
+         gy += lum * vSobelFilter[filter_index++];
+      }
+   }
+
+   float magnitude = sqrt(gx * gx + gy * gy);
+
+   // quantize the gradient direction to 0, 45, 90 or 135 degrees
+   float angle = atan2(gy, gx);
+   if(angle < 0.0f)
+      angle += M_PI_F;
+   uint direction = (uint)((angle + M_PI_F / 8) / (M_PI_F / 4)) % 4;
+
+   // write magnitude and orientation to output
+   int2 coord = (int2)(column, row); 
+   write_imagef(magnitude_image, coord, (float4)(magnitude, magnitude, magnitude, 1.0f));
+   write_imageui(orientation_image, coord, (uint4)(direction, 0, 0, 0));
+}
+
+// largest filter width supported by the filter bank
+#define MAX_FILTER_WIDTH 5
+
+__kernel void filter_bank(read_only image2d_t src_image,
+					__constant float* filters,
+					int num_filters,
+					int radius,
+					write_only image2d_array_t dst_images) {
+
+   // get work-item’s row and column position
+   int column = get_global_id(0); 
+   int row = get_global_id(1);
+
+   // the neighbourhood array below bounds the filter size, larger filters are rejected
+   // rather than read from the table with the wrong stride
+   if(radius < 0 || radius > MAX_FILTER_WIDTH / 2)
+      return;
+
+   // filters are stored one after another, each width * width weights
+   int taps = (2 * radius + 1) * (2 * radius + 1);
+
+   // neighbourhood shared by all filters
+   float4 neighbourhood[MAX_FILTER_WIDTH * MAX_FILTER_WIDTH];
+   int index = 0;
+
+   int2 coord;
+
+   // read the neighbourhood from the image once
+   for(int i = -radius; i <= radius; i++) {
+	  coord.y =  row + i;
+
+	  for(int j = -radius; j <= radius; j++) {
+         coord.x = column + j;
+
+		 neighbourhood[index++] = read_imagef(src_image, sampler, coord);
+	  }
+   }
+
+   // apply every filter to the same neighbourhood
+   for(int f = 0; f < num_filters; f++) {
+      // accumulated pixel value
+      float4 sum = (float4)(0.0);
+
+      for(int t = 0; t < taps; t++) {
+         sum.xyz += neighbourhood[t].xyz * filters[f * taps + t];
+      }
+
+      // write new pixel value to this filter's output slice
+      write_imagef(dst_images, (int4)(column, row, f, 0), sum);
+   }
+}
+
+// 5x5 Gaussian (sigma 1.4) used to smooth the image before edge detection
+__constant float CannyGaussFilter[25] = {	2.0/159,  4.0/159,  5.0/159,  4.0/159, 2.0/159,
+											4.0/159,  9.0/159, 12.0/159,  9.0/159, 4.0/159,
+											5.0/159, 12.0/159, 15.0/159, 12.0/159, 5.0/159,
+											4.0/159,  9.0/159, 12.0/159,  9.0/159, 4.0/159,
+											2.0/159,  4.0/159,  5.0/159,  4.0/159, 2.0/159};
+
+// edge classes held in the edge buffer
+#define EDGE_NONE 0
+#define EDGE_WEAK 1
+#define EDGE_STRONG 2
+
+__kernel void canny_smooth(read_only image2d_t src_image,
+					write_only image2d_t dst_image) {
+
+   // get work-item’s row and column position
+   int column = get_global_id(0); 
+   int row = get_global_id(1);
+
+   // accumulated luminance
+   float sum = 0.0f;
+
+   // filter's current index
+   int filter_index =  0;
+
+   // iterate over the rows and columns
+   for(int i = -2; i <= 2; i++) {
+	  for(int j = -2; j <= 2; j++) {
+		 float4 pixel = read_imagef(src_image, sampler, (int2)(column + j, row + i));
+
+		 sum += (0.299f * pixel.x + 0.587f * pixel.y + 0.114f * pixel.z) * CannyGaussFilter[filter_index++];
+	  }
+   }
+
+   // write smoothed luminance, single channel images keep only the first component
+   write_imagef(dst_image, (int2)(column, row), (float4)(sum, sum, sum, 1.0f));
+}
+
+__kernel void canny_suppress(read_only image2d_t magnitude_image,
+					read_only image2d_t orientation_image,
+					float low_threshold,
+					float high_threshold,
+					__global uchar* edges) {
+
+   // get work-item’s row and column position
+   int column = get_global_id(0); 
+   int row = get_global_id(1);
+   int2 coord = (int2)(column, row);
+
+   // neighbours across the edge for directions 0, 45, 90 and 135 degrees
+   const int2 steps[4] = { (int2)(1, 0), (int2)(1, 1), (int2)(0, 1), (int2)(-1, 1) };
+
+   float magnitude = read_imagef(magnitude_image, sampler, coord).x;
+   int2 step = steps[read_imageui(orientation_image, sampler, coord).x];
+
+   float before = read_imagef(magnitude_image, sampler, coord - step).x;
+   float after = read_imagef(magnitude_image, sampler, coord + step).x;
+
+   // keep only local maxima along the gradient, ties go to the first pixel
+   uchar edge = EDGE_NONE;
+
+   if(magnitude > before && magnitude >= after) {
+      if(magnitude >= high_threshold)
+         edge = EDGE_STRONG;
+      else if(magnitude >= low_threshold)
+         edge = EDGE_WEAK;
+   }
+
+   edges[row * get_image_dim(magnitude_image).x + column] = edge;
+}
+
+__kernel void canny_hysteresis(__global uchar* edges,
+					int width,
+					int height,
+					__global int* changed) {
+
+   __local uchar tile[TILE_SIZE + 2][TILE_SIZE + 2];
+   __local int tile_changed;
+
+   // top-left pixel of the tile including the halo
+   int2 origin = (int2)(get_group_id(0) * TILE_SIZE - 1, get_group_id(1) * TILE_SIZE - 1);
+
+   int lid = get_local_id(1) * TILE_SIZE + get_local_id(0);
+
+   // load the edge classes of the tile, nothing outside the image
+   for(int i = lid; i < (TILE_SIZE + 2) * (TILE_SIZE + 2); i += TILE_SIZE * TILE_SIZE) {
+      int x = origin.x + i % (TILE_SIZE + 2);
+      int y = origin.y + i / (TILE_SIZE + 2);
+
+      tile[i / (TILE_SIZE + 2)][i % (TILE_SIZE + 2)] = (x >= 0 && x < width && y >= 0 && y < height) ? edges[y * width + x] : EDGE_NONE;
+   }
+
+   barrier(CLK_LOCAL_MEM_FENCE);
+
+   // work-item's position in the tile, offset by the halo
+   int tx = get_local_id(0) + 1;
+   int ty = get_local_id(1) + 1;
+   uchar initial = tile[ty][tx];
+   int done = 0;
+
+   // spread strong edges through the tile until it stops changing,
+   // edges crossing into other tiles are picked up by the next launch
+   while(!done) {
+      barrier(CLK_LOCAL_MEM_FENCE);
+      if(lid == 0)
+         tile_changed = 0;
+      barrier(CLK_LOCAL_MEM_FENCE);
+
+      // every work-item reads its neighbours before any of them is promoted
+      int promote = 0;
+
+      if(tile[ty][tx] == EDGE_WEAK) {
+         for(int i = -1; i <= 1; i++) {
+            for(int j = -1; j <= 1; j++) {
+               if(tile[ty + i][tx + j] == EDGE_STRONG)
+                  promote = 1;
+            }
+         }
+      }
+
+      barrier(CLK_LOCAL_MEM_FENCE);
+
+      if(promote) {
+         tile[ty][tx] = EDGE_STRONG;
+         tile_changed = 1;
+      }
+
+      barrier(CLK_LOCAL_MEM_FENCE);
+      done = !tile_changed;
+   }
+
+   // only weak pixels that became strong are written back
+   int column = get_global_id(0); 
+   int row = get_global_id(1);
+
+   if(column < width && row < height && initial == EDGE_WEAK && tile[ty][tx] == EDGE_STRONG) {
+      edges[row * width + column] = EDGE_STRONG;
+      *changed = 1;
+   }
+}
+
+__kernel void canny_output(__global const uchar* edges,
+					write_only image2d_t dst_image) {
+
+   // get work-item’s row and column position
+   int column = get_global_id(0); 
+   int row = get_global_id(1);
+
+   // weak edges never connected to a strong edge are dropped
+   float value = edges[row * get_image_dim(dst_image).x + column] == EDGE_STRONG ? 1.0f : 0.0f;
+
+   write_imagef(dst_image, (int2)(column, row), (float4)(value, value, value, 1.0f));
+}
@@ -16,6 +16,39 @@
 #include "common.h"
 #include "bmpfuncs.h"
 
+#define NUM_BANK_FILTERS 3
+#define BANK_RADIUS 1			// filter bank filters are (2 * BANK_RADIUS + 1) wide
+#define MAX_FILTER_WIDTH 5		// must match MAX_FILTER_WIDTH in simple_conv.cl
+
+// Canny thresholds on the Sobel gradient magnitude of the luminance
+#define CANNY_LOW 0.1f
+#define CANNY_HIGH 0.3f
+#define HYSTERESIS_BATCH 4		// hysteresis launches between reads of the change flag
+
+// 3x3 filters applied together by the filter bank, same as in simple_conv.cl
+const cl_float bankFilters[NUM_BANK_FILTERS * 9] = {
+	// vertical Sobel
+	-1.0f, -2.0f, -1.0f,
+	 0.0f,  0.0f,  0.0f,
+	 1.0f,  2.0f,  1.0f,
+	// blurring
+	1.0f / 9, 1.0f / 9, 1.0f / 9,
+	1.0f / 9, 1.0f / 9, 1.0f / 9,
+	1.0f / 9, 1.0f / 9, 1.0f / 9,
+	// sharpening
+	 0.0f, -1.0f,  0.0f,
+	-1.0f,  5.0f, -1.0f,
+	 0.0f, -1.0f,  0.0f
+};
+
+// the kernel's neighbourhood array holds at most MAX_FILTER_WIDTH x MAX_FILTER_WIDTH pixels
+static_assert(BANK_RADIUS >= 0 && BANK_RADIUS <= MAX_FILTER_WIDTH / 2, "Filter bank radius out of range.");
+static_assert(sizeof(bankFilters) / sizeof(bankFilters[0]) == NUM_BANK_FILTERS * (2 * BANK_RADIUS + 1) * (2 * BANK_RADIUS + 1),
+	"Filter bank table does not match the radius.");
+
+// output file for each filter in the bank
+const char* bankOutputFiles[NUM_BANK_FILTERS] = { "bank_vsobel.bmp", "bank_blur.bmp", "bank_sharpen.bmp" };
+
 int main(void) 
 {
 	cl::Platform platform;			// device's platform
@@ -28,10 +61,16 @@ int main(void)
 	// declare data and memory objects
 	unsigned char* inputImage;
 	unsigned char* outputImage;
+	unsigned char* orientation;
 	int imgWidth, imgHeight, imageSize;
 
 	cl::ImageFormat imgFormat;
 	cl::Image2D inputImgBuffer, outputImgBuffer;
+	cl::Image2D orientationImgBuffer;
+	cl::Image2DArray bankImgBuffer;
+	cl::Buffer bankFilterBuffer;
+	cl::Image2D smoothImgBuffer, magnitudeImgBuffer, directionImgBuffer;
+	cl::Buffer edgeBuffer, changedBuffer;
 
 	try {
 		// select an OpenCL device
@@ -96,11 +135,152 @@ int main(void)
 		// output results to image file
 		write_BMP_RGBA_to_RGB("output.bmp", outputImage, imgWidth, imgHeight);
 
+		// Sobel gradient magnitude and orientation in one pass
+		kernel = cl::Kernel(program, "sobel_gradient");
+
+		// orientation is stored as one direction index per pixel
+		orientation = new unsigned char[imgWidth * imgHeight];
+		orientationImgBuffer = cl::Image2D(context, CL_MEM_WRITE_ONLY, cl::ImageFormat(CL_R, CL_UNSIGNED_INT8), imgWidth, imgHeight);
+
+		// set kernel arguments
+		kernel.setArg(0, inputImgBuffer);
+		kernel.setArg(1, outputImgBuffer);
+		kernel.setArg(2, orientationImgBuffer);
+
+		// global size rounded up to whole 16x16 tiles
+		cl::NDRange tileSize(16, 16);
+		cl::NDRange tiledGlobalSize((imgWidth + 15) / 16 * 16, (imgHeight + 15) / 16 * 16);
+
+		queue.enqueueNDRangeKernel(kernel, offset, tiledGlobalSize, tileSize);
+
+		std::cout << "Sobel gradient Kernel enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
+		queue.enqueueReadImage(orientationImgBuffer, CL_TRUE, origin, region, 0, 0, orientation);
+
+		// output magnitude to image file
+		write_BMP_RGBA_to_RGB("sobel_magnitude.bmp", outputImage, imgWidth, imgHeight);
+
+		// spread the four directions over the grey levels for display
+		for (int i = 0; i < imgWidth * imgHeight; i++)
+		{
+			outputImage[i * 4] = outputImage[i * 4 + 1] = outputImage[i * 4 + 2] = orientation[i] * 85;
+		}
+
+		// output orientation to image file
+		write_BMP_RGBA_to_RGB("sobel_orientation.bmp", outputImage, imgWidth, imgHeight);
+
+		// filter bank, every filter applied to one read of each neighbourhood
+		kernel = cl::Kernel(program, "filter_bank");
+
+		// filters in constant memory and one output slice per filter
+		bankFilterBuffer = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(bankFilters), (void*)bankFilters);
+		bankImgBuffer = cl::Image2DArray(context, CL_MEM_WRITE_ONLY, imgFormat, NUM_BANK_FILTERS, imgWidth, imgHeight, 0, 0);
+
+		// set kernel arguments
+		kernel.setArg(0, inputImgBuffer);
+		kernel.setArg(1, bankFilterBuffer);
+		kernel.setArg(2, NUM_BANK_FILTERS);
+		kernel.setArg(3, BANK_RADIUS);
+		kernel.setArg(4, bankImgBuffer);
+
+		queue.enqueueNDRangeKernel(kernel, offset, globalSize);
+
+		std::cout << "Filter bank Kernel enqueued." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		// read each filter's slice and output it to its image file
+		for (int i = 0; i < NUM_BANK_FILTERS; i++)
+		{
+			cl::size_t<3> sliceOrigin;
+			sliceOrigin[0] = sliceOrigin[1] = 0;
+			sliceOrigin[2] = i;
+
+			queue.enqueueReadImage(bankImgBuffer, CL_TRUE, sliceOrigin, region, 0, 0, outputImage);
+
+			write_BMP_RGBA_to_RGB(bankOutputFiles[i], outputImage, imgWidth, imgHeight);
+		}
+
+		// Canny edge detection, everything stays on the device until the final edge map
+		cl::Kernel smoothKernel(program, "canny_smooth");
+		cl::Kernel gradientKernel(program, "sobel_gradient");
+		cl::Kernel suppressKernel(program, "canny_suppress");
+		cl::Kernel hysteresisKernel(program, "canny_hysteresis");
+		cl::Kernel edgeKernel(program, "canny_output");
+
+		// smoothed luminance and magnitudes are single channel floats, strong gradients are not clamped
+		smoothImgBuffer = cl::Image2D(context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), imgWidth, imgHeight);
+		magnitudeImgBuffer = cl::Image2D(context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), imgWidth, imgHeight);
+		directionImgBuffer = cl::Image2D(context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_UNSIGNED_INT8), imgWidth, imgHeight);
+		edgeBuffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_uchar) * imgWidth * imgHeight);
+		changedBuffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int));
+
+		// Gaussian smoothing
+		smoothKernel.setArg(0, inputImgBuffer);
+		smoothKernel.setArg(1, smoothImgBuffer);
+
+		queue.enqueueNDRangeKernel(smoothKernel, offset, globalSize);
+
+		// gradient magnitude and direction in one pass
+		gradientKernel.setArg(0, smoothImgBuffer);
+		gradientKernel.setArg(1, magnitudeImgBuffer);
+		gradientKernel.setArg(2, directionImgBuffer);
+
+		queue.enqueueNDRangeKernel(gradientKernel, offset, tiledGlobalSize, tileSize);
+
+		// thin the edges and classify them as strong or weak
+		suppressKernel.setArg(0, magnitudeImgBuffer);
+		suppressKernel.setArg(1, directionImgBuffer);
+		suppressKernel.setArg(2, CANNY_LOW);
+		suppressKernel.setArg(3, CANNY_HIGH);
+		suppressKernel.setArg(4, edgeBuffer);
+
+		queue.enqueueNDRangeKernel(suppressKernel, offset, globalSize);
+
+		// promote weak edges connected to strong ones until nothing changes
+		hysteresisKernel.setArg(0, edgeBuffer);
+		hysteresisKernel.setArg(1, imgWidth);
+		hysteresisKernel.setArg(2, imgHeight);
+		hysteresisKernel.setArg(3, changedBuffer);
+
+		cl_int changed = 1;
+		int numLaunches = 0;
+
+		while (changed)
+		{
+			queue.enqueueFillBuffer(changedBuffer, 0, 0, sizeof(cl_int));
+
+			// several launches per check, the flag is the only value read back
+			for (int i = 0; i < HYSTERESIS_BATCH; i++)
+			{
+				queue.enqueueNDRangeKernel(hysteresisKernel, offset, tiledGlobalSize, tileSize);
+			}
+			numLaunches += HYSTERESIS_BATCH;
+
+			queue.enqueueReadBuffer(changedBuffer, CL_TRUE, 0, sizeof(cl_int), &changed);
+		}
+
+		// final edge map
+		edgeKernel.setArg(0, edgeBuffer);
+		edgeKernel.setArg(1, outputImgBuffer);
+
+		queue.enqueueNDRangeKernel(edgeKernel, offset, globalSize);
+
+		std::cout << "Canny Kernels enqueued, " << numLaunches << " hysteresis launches." << std::endl;
+		std::cout << "--------------------" << std::endl;
+
+		queue.enqueueReadImage(outputImgBuffer, CL_TRUE, origin, region, 0, 0, outputImage);
+
+		// output edges to image file
+		write_BMP_RGBA_to_RGB("canny.bmp", outputImage, imgWidth, imgHeight);
+
 		std::cout << "Done." << std::endl;
 
 		// deallocate memory
 		free(inputImage);
 		free(outputImage);
+		delete[] orientation;
 	}
 	// catch any OpenCL function errors
 	catch (cl::Error e) {